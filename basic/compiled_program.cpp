@@ -0,0 +1,101 @@
+//
+// Created by pro on 2024/3/5.
+//
+
+#include "istool/basic/compiled_program.h"
+#include <cassert>
+
+Instruction::Instruction(InstructionType _type, int _id, const Data &_w, FullExecutedSemantics *_semantics, Program *_program):
+    type(_type), id(_id), w(_w), semantics(_semantics), program(_program) {
+}
+
+CompiledProgram::CompiledProgram(const PProgram &_source): source(_source) {
+    compile(source.get());
+}
+
+void CompiledProgram::compile(Program *program) {
+    auto* sem = program->semantics.get();
+    if (auto* ps = dynamic_cast<ParamSemantics*>(sem)) {
+        instruction_list.emplace_back(InstructionType::PARAM, ps->id, Data(), nullptr, nullptr);
+        return;
+    }
+    if (auto* cs = dynamic_cast<ConstSemantics*>(sem)) {
+        instruction_list.emplace_back(InstructionType::CONST, 0, cs->w, nullptr, nullptr);
+        return;
+    }
+    auto* fs = dynamic_cast<FullExecutedSemantics*>(sem);
+    if (!fs) {
+        instruction_list.emplace_back(InstructionType::TREE, 0, Data(), nullptr, program);
+        return;
+    }
+    if (fs->isLazy()) {
+        ProgramList sub_list;
+        for (auto& sub: program->sub_list) {
+            if (sub->sub_list.empty()) sub_list.push_back(sub);
+            else {
+                auto compiled_sub = std::make_shared<CompiledSemantics>(std::make_shared<CompiledProgram>(sub));
+                sub_list.push_back(std::make_shared<Program>(compiled_sub, ProgramList()));
+            }
+        }
+        shadow_list.push_back(std::make_shared<Program>(program->semantics, sub_list));
+        instruction_list.emplace_back(InstructionType::TREE, 0, Data(), nullptr, shadow_list.rbegin()->get());
+        return;
+    }
+    for (auto& sub: program->sub_list) compile(sub.get());
+    instruction_list.emplace_back(InstructionType::INVOKE, int(program->sub_list.size()), Data(), fs, nullptr);
+    instruction_list.rbegin()->arg_buffer.reserve(program->sub_list.size());
+}
+
+Data CompiledProgram::run(ExecuteInfo *info) {
+    // The stack may be left non-empty if the previous run was interrupted by an exception.
+    stack.clear();
+    for (auto& instruction: instruction_list) {
+        // A TREE instruction consumes fuel in Program::run, and other instructions consume one step each.
+        if (info->fuel >= 0 && instruction.type != InstructionType::TREE) info->consumeFuel();
+        switch (instruction.type) {
+            case InstructionType::PARAM: {
+                stack.push_back(info->param_value[instruction.id]);
+                break;
+            }
+            case InstructionType::CONST: {
+                stack.push_back(instruction.w);
+                break;
+            }
+            case InstructionType::TREE: {
+                stack.push_back(instruction.program->run(info));
+                break;
+            }
+            case InstructionType::INVOKE: {
+                auto& args = instruction.arg_buffer;
+                args.clear();
+                auto start = stack.end() - instruction.id;
+                bool is_error = false;
+                for (auto it = start; it != stack.end(); ++it) {
+                    is_error |= it->isError(); args.push_back(std::move(*it));
+                }
+                stack.erase(start, stack.end());
+                if (is_error) stack.push_back(data::buildError());
+                else stack.push_back(instruction.semantics->run(std::move(args), info));
+                break;
+            }
+        }
+    }
+    assert(stack.size() == 1);
+    return std::move(stack[0]);
+}
+
+Program *CompiledProgram::getSource() const {
+    return source.get();
+}
+
+CompiledSemantics::CompiledSemantics(const PCompiledProgram &_program): Semantics("compiled"), program(_program) {
+}
+Data CompiledSemantics::run(const ProgramList &sub_list, ExecuteInfo *info) {
+    return program->run(info);
+}
+std::string CompiledSemantics::buildProgramString(const std::vector<std::string> &sub_exp) {
+    return program->getSource()->toString();
+}
+uint64_t CompiledSemantics::buildFingerprint(const std::vector<uint64_t> &sub_list) {
+    return program->getSource()->getFingerprint();
+}
@@ -5,20 +5,131 @@
 #include "istool/basic/data.h"
 #include "istool/basic/semantics.h"
 #include <cassert>
+#include <atomic>
 #include "glog/logging.h"
 
-Data::Data(): value(new NullValue()) {
+namespace {
+    const int KSmallIntMin = -1024, KSmallIntMax = 1024;
+
+    Value* _getSmallInt(int w) {
+        static std::vector<PValue> small_int_list = []() {
+            std::vector<PValue> res;
+            for (int i = KSmallIntMin; i <= KSmallIntMax; ++i) res.push_back(std::make_shared<IntValue>(i));
+            return res;
+        }();
+        return small_int_list[w - KSmallIntMin].get();
+    }
+}
+
+Data::Data(): kind(DataKind::NONE), w(0) {
+}
+
+Data::Data(DataKind _kind, int _w): kind(_kind), w(_w) {
+}
+
+Data::Data(PValue &&_value): kind(DataKind::VALUE), w(0), value(std::move(_value)) {
+}
+
+Data::Data(const Data &d): kind(d.kind), w(d.w) {
+    if (kind == DataKind::VALUE) value = d.value;
+}
+
+Data::Data(Data &&d) noexcept: kind(d.kind), w(d.w) {
+    if (kind == DataKind::VALUE) value = std::move(d.value);
+}
+
+Data &Data::operator=(const Data &d) {
+    kind = d.kind; w = d.w;
+    if (kind == DataKind::VALUE) value = d.value; else value.reset();
+    return *this;
 }
 
-Data::Data(PValue &&_value): value(_value) {
+Data &Data::operator=(Data &&d) noexcept {
+    kind = d.kind; w = d.w;
+    if (kind == DataKind::VALUE) value = std::move(d.value); else value.reset();
+    return *this;
+}
+
+Data data::buildInt(int w) {
+    return {DataKind::INT, w};
+}
+
+Data data::buildBool(bool w) {
+    return {DataKind::BOOL, w};
+}
+
+Data data::buildUnit() {
+    return {DataKind::UNIT, 0};
+}
+
+Data data::buildError() {
+    return {DataKind::ERROR, 0};
+}
+
+Value *Data::getBoxedValue() const {
+    static NullValue null_value;
+    static BoolValue true_value(true), false_value(false);
+    static UnitValue unit_value;
+    switch (kind) {
+        case DataKind::NONE: return &null_value;
+        case DataKind::BOOL: return w ? &true_value : &false_value;
+        case DataKind::UNIT: return &unit_value;
+        case DataKind::INT: {
+            if (w >= KSmallIntMin && w <= KSmallIntMax) return _getSmallInt(w);
+            // Large ints are boxed on the first access. The box is published atomically since a constant Data may be
+            // shared by several threads.
+            auto current = std::atomic_load(&value);
+            if (current) return current.get();
+            PValue boxed = std::make_shared<IntValue>(w);
+            if (std::atomic_compare_exchange_strong(&value, &current, boxed)) return boxed.get();
+            return current.get();
+        }
+        case DataKind::VALUE: return value.get();
+        case DataKind::ERROR: throw SemanticsError();
+    }
+    LOG(FATAL) << "Unknown data kind " << int(kind);
+    return nullptr;
 }
 
 std::string Data::toString() const {
-    return value->toString();
+    switch (kind) {
+        case DataKind::NONE: return "null";
+        case DataKind::INT: return std::to_string(w);
+        case DataKind::BOOL: return w ? "true" : "false";
+        case DataKind::UNIT: return "unit";
+        case DataKind::VALUE: return value->toString();
+        case DataKind::ERROR: return "error";
+    }
+    LOG(FATAL) << "Unknown data kind " << int(kind);
+    return "";
 }
 
 bool Data::operator==(const Data &d) const {
-    return value->equal(d.value.get());
+    if (kind != DataKind::VALUE && d.kind != DataKind::VALUE) {
+        return kind == d.kind && w == d.w;
+    }
+    if (kind == DataKind::VALUE && d.kind == DataKind::VALUE && value == d.value) return true;
+    return get()->equal(d.get());
+}
+
+namespace {
+    size_t _mixHash(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31u);
+    }
+}
+
+size_t Data::hash() const {
+    if (kind == DataKind::VALUE) return value->hash();
+    return _mixHash((uint64_t(kind) << 32u) | uint32_t(w));
+}
+
+bool Data::isIdentical(const Data &d) const {
+    if (kind != d.kind) return false;
+    if (kind == DataKind::VALUE) return value == d.value;
+    return w == d.w;
 }
 
 bool Data::operator < (const Data& d) const {
@@ -26,26 +137,56 @@ bool Data::operator < (const Data& d) const {
 }
 
 bool Data::operator <= (const Data& d) const {
-    auto* cv1 = dynamic_cast<ComparableValue*>(value.get());
-    auto* cv2 = dynamic_cast<ComparableValue*>(d.value.get());
+    if (kind == DataKind::INT && d.kind == DataKind::INT) return w <= d.w;
+    auto* cv1 = dynamic_cast<ComparableValue*>(get());
+    auto* cv2 = dynamic_cast<ComparableValue*>(d.get());
     if (!cv1 || !cv2) throw SemanticsError();
-    return cv1->leq(d.value.get());
+    return cv1->leq(d.get());
 }
 
 Value * Data::get() const {
-    return value.get();
+    if (kind == DataKind::VALUE) return value.get();
+    return getBoxedValue();
 }
 
 bool Data::isTrue() const {
-    auto* bv = dynamic_cast<BoolValue*>(value.get());
+    if (kind == DataKind::BOOL) return w;
+    auto* bv = dynamic_cast<BoolValue*>(get());
     return bv->w;
 }
 
 bool Data::isNull() const {
+    if (kind != DataKind::VALUE) return kind == DataKind::NONE;
     auto* nv = dynamic_cast<NullValue*>(value.get());
     return nv;
 }
 
+bool Data::isError() const {
+    return kind == DataKind::ERROR;
+}
+
+DataKind Data::getKind() const {
+    return kind;
+}
+
+bool Data::isInlinedInt() const {
+    return kind == DataKind::INT;
+}
+
+int Data::getInlinedInt() const {
+    return w;
+}
+
+size_t data::hashCombine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6u) + (seed >> 2u));
+}
+
+size_t data::hashDataList(const DataList &data_list) {
+    size_t res = data_list.size();
+    for (auto& d: data_list) res = hashCombine(res, d.hash());
+    return res;
+}
+
 std::string data::dataList2String(const DataList &data_list) {
     if (data_list.empty()) return "[]";
     std::string res;
@@ -77,4 +218,22 @@ DataStorage data::cartesianProduct(const DataStorage &separate_data) {
     DataList cur; DataStorage res;
     _cartesianProduct(0, separate_data, cur, res);
     return res;
-}
\ No newline at end of file
+}
+Data DataHashConsTable::intern(const Data &d) {
+    if (d.getKind() != DataKind::VALUE) return d;
+    return *table.insert(d).first;
+}
+
+DataList DataHashConsTable::intern(const DataList &data_list) {
+    DataList res;
+    for (auto& d: data_list) res.push_back(intern(d));
+    return res;
+}
+
+int DataHashConsTable::size() const {
+    return table.size();
+}
+
+void DataHashConsTable::clear() {
+    table.clear();
+}
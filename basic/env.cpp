@@ -4,96 +4,259 @@
 
 #include "istool/basic/env.h"
 #include "istool/basic/program.h"
+#include "istool/basic/compiled_program.h"
 #include "glog/logging.h"
 #include <sys/time.h>
+#include <mutex>
 
-Env::Env(): random_engine(0) {
+namespace {
+    std::atomic<int> info_builder_counter(0);
+
+    // The free ExecuteInfo objects of the current thread, all of which are built by the builder of the given id.
+    struct ExecuteInfoPool {
+        int builder_id = -1;
+        std::vector<ExecuteInfo*> free_list;
+        void clear() {
+            for (auto* info: free_list) delete info;
+            free_list.clear();
+        }
+        ~ExecuteInfoPool() {clear();}
+    };
+
+    thread_local ExecuteInfoPool info_pool;
+}
+
+Env::Env(): state(std::make_shared<EnvState>()), seed(0), evaluation_fuel(-1), fork_num(0), random_engine(0) {
     semantics::loadLogicSemantics(this);
-    info_builder = new ExecuteInfoBuilder();
+    setExecuteInfoBuilder(new ExecuteInfoBuilder());
 }
 
-int Env::setRandomSeed(int seed) {
+Env::Env(const std::shared_ptr<EnvState> &_state, int _seed): state(_state), seed(_seed), evaluation_fuel(-1), fork_num(0), random_engine(_seed) {
+}
+
+namespace {
+    int _deriveSeed(int seed, int fork_id) {
+        uint64_t x = (uint64_t(uint32_t(seed)) << 32u) | uint32_t(fork_id);
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+        return int((x ^ (x >> 31u)) & 0x7fffffff);
+    }
+}
+
+std::shared_ptr<Env> Env::forkForThread() {
+    int fork_id = ++fork_num;
+    return std::shared_ptr<Env>(new Env(state, _deriveSeed(seed, fork_id)));
+}
+
+int Env::setRandomSeed(int _seed) {
+    seed = _seed; fork_num = 0;
     random_engine.seed(seed);
     return seed;
 }
 
+int Env::getRandomSeed() const {
+    return seed;
+}
+
 Data * Env::getConstRef(const std::string &name, const Data& default_value) {
     //LOG(INFO) << "Get " << this << " " << name; int kk; std::cin >> kk;
-    if (const_pool.find(name) == const_pool.end()) {
-        const_pool[name] = new Data(default_value);
-    }
-    if (!default_value.isNull() && const_pool[name]->isNull()) {
-        delete const_pool[name];
-        const_pool[name] = new Data(default_value);
+    {
+        std::shared_lock<std::shared_mutex> guard(state->lock);
+        auto it = state->const_pool.find(name);
+        if (it != state->const_pool.end() && (default_value.isNull() || !it->second->isNull())) return it->second;
     }
-    return const_pool[name];
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    auto& res = state->const_pool[name];
+    if (!res) res = new Data(default_value);
+    // Overwrite in place, since the pointer may have been returned before.
+    if (!default_value.isNull() && res->isNull()) *res = default_value;
+    return res;
 }
 
 ExecuteInfoBuilder *Env::getExecuteInfoBuilder() {
-    return info_builder;
+    return state->info_builder;
+}
+
+void Env::setEvaluationFuel(int fuel) {
+    evaluation_fuel = fuel;
+}
+
+int Env::getEvaluationFuel() const {
+    return evaluation_fuel;
+}
+
+EvaluationFuelScope::EvaluationFuelScope(Env *_env, int fuel): env(_env), pre_fuel(_env->getEvaluationFuel()) {
+    env->setEvaluationFuel(fuel);
+}
+
+EvaluationFuelScope::~EvaluationFuelScope() {
+    env->setEvaluationFuel(pre_fuel);
 }
 
 void Env::setConst(const std::string &name, const Data &value) {
     //LOG(INFO) << "Set " << this << " " << name; int kk; std::cin >> kk;
-    if (const_pool.find(name) == const_pool.end()) {
-        const_pool[name] = new Data();
-    }
-    *(const_pool[name]) = value;
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    auto& res = state->const_pool[name];
+    if (!res) res = new Data();
+    *res = value;
 }
 
 DataList * Env::getConstListRef(const std::string &name) {
-    if (const_list_pool.find(name) == const_list_pool.end()) {
-        const_list_pool[name] = new DataList();
-    }
-    return const_list_pool[name];
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    auto& res = state->const_list_pool[name];
+    if (!res) res = new DataList();
+    return res;
 }
 
 void Env::setConst(const std::string &name, const DataList &value) {
-    if (const_list_pool.find(name) == const_list_pool.end()) {
-        const_list_pool[name] = new DataList();
-    }
-    *(const_list_pool[name]) = value;
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    auto& res = state->const_list_pool[name];
+    if (!res) res = new DataList();
+    *res = value;
 }
 
-Env::~Env() {
+Env::EnvState::~EnvState() {
     for (auto& const_info: const_pool) {
         delete const_info.second;
     }
+    for (auto& const_info: const_list_pool) {
+        delete const_info.second;
+    }
     for (auto& ext_info: extension_pool) {
         delete ext_info.second;
     }
     delete info_builder;
 }
 
+Env::~Env() = default;
+
 Extension * Env::getExtension(const std::string &name) const {
-    if (extension_pool.find(name) == extension_pool.end()) {
+    std::shared_lock<std::shared_mutex> guard(state->lock);
+    auto it = state->extension_pool.find(name);
+    if (it == state->extension_pool.end()) {
         return nullptr;
     }
-    return extension_pool.find(name)->second;
+    return it->second;
 }
 void Env::registerExtension(const std::string &name, Extension *ext) {
-    extension_pool[name] = ext;
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    state->extension_pool[name] = ext;
 }
 
 void Env::setSemantics(const std::string &name, const PSemantics &semantics) {
-    semantics_pool[name] = semantics;
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    state->semantics_pool[name] = semantics;
 }
 PSemantics Env::getSemantics(const std::string &name) const {
-    if (semantics_pool.find(name) == semantics_pool.end()) {
+    std::shared_lock<std::shared_mutex> guard(state->lock);
+    auto it = state->semantics_pool.find(name);
+    if (it == state->semantics_pool.end()) {
         LOG(FATAL) << "Unknown semantics " << name;
     }
-    return semantics_pool.find(name)->second;
+    return it->second;
 }
 
 void Env::setExecuteInfoBuilder(ExecuteInfoBuilder *builder) {
-    delete info_builder;
-    info_builder = builder;
+    std::unique_lock<std::shared_mutex> guard(state->lock);
+    delete state->info_builder;
+    state->info_builder = builder;
+    state->info_builder_id = info_builder_counter++;
+}
+
+ExecuteInfo *Env::acquireInfo(const ParamView &param, const FunctionContext &ctx) {
+    if (info_pool.builder_id != state->info_builder_id) {
+        info_pool.clear(); info_pool.builder_id = state->info_builder_id;
+    }
+    ExecuteInfo* info;
+    if (info_pool.free_list.empty()) info = state->info_builder->buildInfo(param, ctx);
+    else {
+        info = info_pool.free_list.back(); info_pool.free_list.pop_back();
+        state->info_builder->resetInfo(info, param, ctx);
+    }
+    info->fuel = evaluation_fuel;
+    return info;
+}
+
+void Env::releaseInfo(ExecuteInfo *info) {
+    // The info is dropped if the pool has been taken by another builder, e.g., by a nested execution of another env.
+    if (info_pool.builder_id == state->info_builder_id) info_pool.free_list.push_back(info);
+    else delete info;
 }
 
 Data Env::run(Program *program, const DataList &param_list, const FunctionContext &ctx) {
-    auto* info = info_builder->buildInfo(param_list, ctx);
-    auto res = program->run(info);
-    delete info; return res;
+    return run(program, ParamView(param_list), ctx);
+}
+
+Data Env::tryRun(Program *program, const DataList &param_list, const FunctionContext &ctx) {
+    return tryRun(program, ParamView(param_list), ctx);
+}
+
+Data Env::run(Program *program, const ParamView &param, const FunctionContext &ctx) {
+    auto res = tryRun(program, param, ctx);
+    if (res.isError()) throw SemanticsError();
+    return res;
+}
+
+Data Env::tryRun(Program *program, const ParamView &param, const FunctionContext &ctx) {
+    auto* info = acquireInfo(param, ctx);
+    Data res;
+    try {
+        res = program->run(info);
+    } catch (const SemanticsError& e) {
+        res = data::buildError();
+    }
+    releaseInfo(info); return res;
+}
+
+namespace {
+    // Examples are evaluated in blocks such that the columns of intermediate results stay in cache.
+    const int KBatchBlockSize = 256;
+}
+
+DataList Env::runBatch(Program *program, const DataStorage &example_list, const FunctionContext &ctx) {
+    DataList res;
+    std::vector<ExecuteInfo*> info_list;
+    for (int start = 0; start < example_list.size(); start += KBatchBlockSize) {
+        int end = std::min(int(example_list.size()), start + KBatchBlockSize);
+        for (int i = start; i < end; ++i) info_list.push_back(acquireInfo(example_list[i], ctx));
+        DataList block_res;
+        try {
+            block_res = program->runBatch(info_list);
+        } catch (...) {
+            for (auto* info: info_list) releaseInfo(info);
+            throw;
+        }
+        for (auto* info: info_list) releaseInfo(info);
+        info_list.clear();
+        for (auto& d: block_res) res.push_back(std::move(d));
+    }
+    return res;
+}
+
+Data Env::run(CompiledProgram *program, const DataList &param_list, const FunctionContext &ctx) {
+    return run(program, ParamView(param_list), ctx);
+}
+
+Data Env::tryRun(CompiledProgram *program, const DataList &param_list, const FunctionContext &ctx) {
+    return tryRun(program, ParamView(param_list), ctx);
+}
+
+Data Env::run(CompiledProgram *program, const ParamView &param, const FunctionContext &ctx) {
+    auto res = tryRun(program, param, ctx);
+    if (res.isError()) throw SemanticsError();
+    return res;
+}
+
+Data Env::tryRun(CompiledProgram *program, const ParamView &param, const FunctionContext &ctx) {
+    auto* info = acquireInfo(param, ctx);
+    Data res;
+    try {
+        res = program->run(info);
+    } catch (const SemanticsError& e) {
+        res = data::buildError();
+    }
+    releaseInfo(info); return res;
 }
 
 void env::setTimeSeed(Env* env) {
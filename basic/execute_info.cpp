@@ -3,10 +3,38 @@
 //
 
 #include "istool/basic/execute_info.h"
+#include "istool/basic/semantics.h"
 
-ExecuteInfo::ExecuteInfo(const DataList &_param_value, const FunctionContext &_context):
-    param_value(_param_value), func_context(_context) {
+ParamView::ParamView(): local(nullptr), global(nullptr), local_size(0), global_size(0) {
 }
-ExecuteInfo * ExecuteInfoBuilder::buildInfo(const DataList &_param_value, const FunctionContext &ctx) {
+ParamView::ParamView(const DataList &param_list):
+    local(param_list.data()), global(nullptr), local_size(int(param_list.size())), global_size(0) {
+}
+ParamView::ParamView(const DataList &local_list, const DataList &global_list):
+    local(local_list.data()), global(global_list.data()), local_size(int(local_list.size())), global_size(int(global_list.size())) {
+}
+ParamView::ParamView(const Data *_local, int _local_size, const Data *_global, int _global_size):
+    local(_local), global(_global), local_size(_local_size), global_size(_global_size) {
+}
+int ParamView::size() const {
+    return local_size + global_size;
+}
+DataList ParamView::toDataList() const {
+    DataList res(local, local + local_size);
+    for (int i = 0; i < global_size; ++i) res.push_back(global[i]);
+    return res;
+}
+
+ExecuteInfo::ExecuteInfo(const ParamView &_param_value, const FunctionContext &_context):
+    param_value(_param_value), func_context(_context), fuel(-1) {
+}
+void ExecuteInfo::consumeFuel() {
+    if (fuel > 0) --fuel;
+    else if (fuel == 0) throw SemanticsError();
+}
+ExecuteInfo * ExecuteInfoBuilder::buildInfo(const ParamView &_param_value, const FunctionContext &ctx) {
     return new ExecuteInfo(_param_value, ctx);
+}
+void ExecuteInfoBuilder::resetInfo(ExecuteInfo *info, const ParamView &_param_value, const FunctionContext &ctx) {
+    info->param_value = _param_value; info->func_context = ctx;
 }
\ No newline at end of file
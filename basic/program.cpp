@@ -6,7 +6,7 @@
 #include "glog/logging.h"
 
 Program::Program(const PSemantics &_semantics, const ProgramList &_sub_list):
-    sub_list(_sub_list), semantics(_semantics) {
+    fingerprint(0), sub_list(_sub_list), semantics(_semantics) {
 }
 int Program::size() const {
     int res = 1;
@@ -16,9 +16,63 @@ int Program::size() const {
     return res;
 }
 Data Program::run(ExecuteInfo *info) const {
+    if (info->fuel >= 0) info->consumeFuel();
     auto res = semantics->run(sub_list, info);
     return res;
 }
+namespace {
+    void _checkBatchResult(const DataList& res) {
+        for (auto& d: res) {
+            if (d.isError()) throw SemanticsError();
+        }
+    }
+}
+
+DataList Program::runBatch(const std::vector<ExecuteInfo *> &info_list) const {
+    // The root consumes fuel here, so semantics->run is invoked directly below instead of run.
+    for (auto* info: info_list) {
+        if (info->fuel >= 0) info->consumeFuel();
+    }
+    if (auto* ps = dynamic_cast<ParamSemantics*>(semantics.get())) {
+        DataList res;
+        for (auto* info: info_list) res.push_back(info->param_value[ps->id]);
+        return res;
+    }
+    if (auto* cs = dynamic_cast<ConstSemantics*>(semantics.get())) {
+        return DataList(info_list.size(), cs->w);
+    }
+    auto* fs = dynamic_cast<FullExecutedSemantics*>(semantics.get());
+    DataList res;
+    if (!fs) {
+        for (auto* info: info_list) res.push_back(semantics->run(sub_list, info));
+        _checkBatchResult(res);
+        return res;
+    }
+    std::vector<DataList> inp_list;
+    if (fs->isLazy()) {
+        // A lazy semantics is evaluated eagerly first, which is equivalent when no sub-program fails. Otherwise,
+        // fall back to the example-wise evaluation to skip the failed branches.
+        try {
+            for (const auto& sub: sub_list) inp_list.push_back(sub->runBatch(info_list));
+        } catch (SemanticsError& e) {
+            for (auto* info: info_list) res.push_back(semantics->run(sub_list, info));
+            _checkBatchResult(res);
+            return res;
+        }
+        return fs->runBatch(std::move(inp_list), info_list);
+    }
+    for (const auto& sub: sub_list) inp_list.push_back(sub->runBatch(info_list));
+    return fs->runBatch(std::move(inp_list), info_list);
+}
+uint64_t Program::getFingerprint() const {
+    if (fingerprint) return fingerprint;
+    std::vector<uint64_t> sub_fingerprint_list;
+    for (auto& sub: sub_list) sub_fingerprint_list.push_back(sub->getFingerprint());
+    auto res = semantics->buildFingerprint(sub_fingerprint_list);
+    fingerprint = res ? res : 1;
+    return fingerprint;
+}
+
 std::string Program::toString() const {
     std::vector<std::string> sub_expr_list;
     for (auto& sub: sub_list) sub_expr_list.push_back(sub->toString());
@@ -0,0 +1,123 @@
+//
+// Created by pro on 2024/3/8.
+//
+
+#include "istool/basic/program_store.h"
+
+bool ProgramStore::NodeKey::operator==(const NodeKey &key) const {
+    return name == key.name && sub_id_list == key.sub_id_list;
+}
+
+size_t ProgramStore::NodeKeyHash::operator()(const NodeKey &key) const {
+    auto res = std::hash<std::string>()(key.name);
+    for (auto id: key.sub_id_list) res = data::hashCombine(res, id);
+    return res;
+}
+
+int ProgramStore::insert(const PProgram &program) {
+    auto it = program_map.find(program.get());
+    if (it != program_map.end()) return it->second;
+    NodeKey key{program->semantics->getName(), {}};
+    for (auto& sub: program->sub_list) key.sub_id_list.push_back(insert(sub));
+    auto node_it = node_map.find(key);
+    if (node_it != node_map.end()) return node_it->second;
+    int id = size();
+    node_list.push_back(program);
+    sub_id_storage.push_back(key.sub_id_list);
+    node_map[std::move(key)] = id;
+    program_map[program.get()] = id;
+    return id;
+}
+
+int ProgramStore::size() const {
+    return node_list.size();
+}
+
+void ProgramStore::clear() {
+    node_map.clear(); program_map.clear();
+    node_list.clear(); sub_id_storage.clear();
+}
+
+ProgramEvalCache::ProgramEvalCache(const DataStorage &_example_list, Env *_env): env(_env), example_list(_example_list) {
+    // The infos view the examples owned by the cache, which are never modified afterward.
+    auto* builder = env->getExecuteInfoBuilder();
+    for (auto& example: example_list) info_list.push_back(builder->buildInfo(example, {}));
+}
+
+void ProgramEvalCache::extend() {
+    result_storage.resize(store.size());
+    is_evaluated.resize(store.size(), false);
+}
+
+DataList ProgramEvalCache::runRoot(Program *program, const std::vector<int> &sub_id_list) {
+    DataList res;
+    auto* fs = dynamic_cast<FullExecutedSemantics*>(program->semantics.get());
+    if (!fs || sub_id_list.empty()) {
+        for (auto* info: info_list) {
+            try {
+                res.push_back(program->run(info));
+            } catch (const SemanticsError& e) {
+                res.push_back(data::buildError());
+            }
+        }
+        return res;
+    }
+    // Compute all sub-results first, since the storage is not modified afterward and thus the pointers stay valid.
+    for (auto id: sub_id_list) getResult(id);
+    std::vector<const DataList*> sub_result_list;
+    for (auto id: sub_id_list) sub_result_list.push_back(&result_storage[id]);
+    for (int i = 0; i < info_list.size(); ++i) {
+        DataList inp_list; bool is_error = false;
+        for (auto* sub_result: sub_result_list) {
+            is_error |= sub_result->at(i).isError(); inp_list.push_back(sub_result->at(i));
+        }
+        if (is_error) {
+            // A lazy semantics may not touch the failed sub-programs, so it is evaluated in the tree form.
+            if (fs->isLazy()) {
+                try {
+                    res.push_back(program->run(info_list[i]));
+                } catch (const SemanticsError& e) {
+                    res.push_back(data::buildError());
+                }
+            } else res.push_back(data::buildError());
+            continue;
+        }
+        try {
+            res.push_back(fs->run(std::move(inp_list), info_list[i]));
+        } catch (const SemanticsError& e) {
+            res.push_back(data::buildError());
+        }
+    }
+    return res;
+}
+
+DataList ProgramEvalCache::run(const PProgram &program) {
+    std::vector<int> sub_id_list;
+    for (auto& sub: program->sub_list) sub_id_list.push_back(store.insert(sub));
+    extend();
+    return runRoot(program.get(), sub_id_list);
+}
+
+int ProgramEvalCache::insert(const PProgram &program, const DataList &result) {
+    int id = store.insert(program); extend();
+    if (!is_evaluated[id]) {
+        result_storage[id] = result; is_evaluated[id] = true;
+    }
+    return id;
+}
+
+const DataList &ProgramEvalCache::getResult(int node_id) {
+    if (!is_evaluated[node_id]) {
+        result_storage[node_id] = runRoot(store.node_list[node_id].get(), store.sub_id_storage[node_id]);
+        is_evaluated[node_id] = true;
+    }
+    return result_storage[node_id];
+}
+
+int ProgramEvalCache::getExampleNum() const {
+    return example_list.size();
+}
+
+ProgramEvalCache::~ProgramEvalCache() {
+    for (auto* info: info_list) delete info;
+}
@@ -21,6 +21,19 @@ std::string Semantics::buildProgramString(const std::vector<std::string> &sub_li
     return res + ")";
 }
 
+uint64_t Semantics::buildFingerprint(const std::vector<uint64_t> &sub_list) {
+    uint64_t res = std::hash<std::string>()(name);
+    for (auto sub: sub_list) res = semantics::combineFingerprint(res, sub);
+    return res;
+}
+
+uint64_t semantics::combineFingerprint(uint64_t seed, uint64_t value) {
+    uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6u) + (seed >> 2u));
+    x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31u);
+}
+
 std::string Semantics::buildProgramStringToHaskell(const std::vector<std::string> &sub_list) {
     std::string res = name;
     /* already modified in composed_rule.cpp/_buildSketchToHaskell
@@ -56,9 +69,25 @@ std::string Semantics::buildProgramStringToHaskell(const std::vector<std::string
 FullExecutedSemantics::FullExecutedSemantics(const std::string &name): Semantics(name) {}
 Data FullExecutedSemantics::run(const std::vector<std::shared_ptr<Program>> &sub_list, ExecuteInfo *info) {
     DataList res;
-    for (const auto& p: sub_list) res.push_back(p->run(info));
+    for (const auto& p: sub_list) {
+        res.push_back(p->run(info));
+        if (res.back().isError()) return res.back();
+    }
     return run(std::move(res), info);
 }
+bool FullExecutedSemantics::isLazy() const {
+    return false;
+}
+DataList FullExecutedSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    DataList res;
+    for (int i = 0; i < info_list.size(); ++i) {
+        DataList inp;
+        for (auto& column: inp_list) inp.push_back(std::move(column[i]));
+        res.push_back(run(std::move(inp), info_list[i]));
+        if (res.back().isError()) throw SemanticsError();
+    }
+    return res;
+}
 
 NormalSemantics::NormalSemantics(const std::string& name, const PType &_oup_type, const TypeList &_inp_list):
     TypedSemantics(std::move(_oup_type), std::move(_inp_list)), FullExecutedSemantics(name) {
@@ -108,6 +137,15 @@ std::string FunctionContext::toString() const {
     return res;
 }
 
+uint64_t FunctionContext::getFingerprint() const {
+    // The entries are summed up, since the iteration order of an unordered_map is unspecified.
+    uint64_t res = 0;
+    for (const auto& info: *this) {
+        res += semantics::combineFingerprint(std::hash<std::string>()(info.first), info.second->getFingerprint());
+    }
+    return res;
+}
+
 DirectSemantics::DirectSemantics(): NormalSemantics("", type::getTVarA(), {type::getTVarA()}) {}
 Data DirectSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     return inp_list[0];
@@ -115,13 +153,16 @@ Data DirectSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 std::string DirectSemantics::buildProgramString(const std::vector<std::string> &sub_exp) {
     return sub_exp[0];
 }
+uint64_t DirectSemantics::buildFingerprint(const std::vector<uint64_t> &sub_list) {
+    return sub_list[0];
+}
 
 InvokeSemantics::InvokeSemantics(const std::string &_func_name, Env *_env): FullExecutedSemantics(_func_name), env(_env) {
 }
 Data InvokeSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto p = info->func_context[name];
-    if (!p) throw SemanticsError();
-    return env->run(p.get(), inp_list);
+    if (!p) return data::buildError();
+    return env->tryRun(p.get(), inp_list);
 }
 
 
@@ -130,11 +171,18 @@ TypedInvokeSemantics::TypedInvokeSemantics(const std::string &_func_name, const
 }
 
 #define TBOOL type::getTBool()
+#define BOOL_BATCH(op) \
+    DataList res(inp_list[0].size()); \
+    for (int i = 0; i < res.size(); ++i) { \
+        bool x = inp_list[0][i].isTrue(), y = inp_list[1][i].isTrue(); \
+        res[i] = BuildData(Bool, op); \
+    } \
+    return res
 
 NotSemantics::NotSemantics(): NormalSemantics("!", TBOOL, {TBOOL}) {
 }
 Data NotSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
-    return Data(std::make_shared<BoolValue>(!inp_list[0].isTrue()));
+    return BuildData(Bool, !inp_list[0].isTrue());
 }
 
 AndSemantics::AndSemantics(): NormalSemantics("&&", TBOOL, {TBOOL, TBOOL}) {
@@ -144,9 +192,15 @@ Data AndSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 }
 Data AndSemantics::run(const ProgramList &sub_list, ExecuteInfo *info) {
     auto x = sub_list[0]->run(info);
-    if (!x.isTrue()) return x;
+    if (x.isError() || !x.isTrue()) return x;
     return sub_list[1]->run(info);
 }
+bool AndSemantics::isLazy() const {
+    return true;
+}
+DataList AndSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    BOOL_BATCH(x && y);
+}
 
 OrSemantics::OrSemantics(): NormalSemantics("||", TBOOL, {TBOOL, TBOOL}) {
 }
@@ -155,9 +209,15 @@ Data OrSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 }
 Data OrSemantics::run(const ProgramList &sub_list, ExecuteInfo *info) {
     auto x = sub_list[0]->run(info);
-    if (x.isTrue()) return x;
+    if (x.isError() || x.isTrue()) return x;
     return sub_list[1]->run(info);
 }
+bool OrSemantics::isLazy() const {
+    return true;
+}
+DataList OrSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    BOOL_BATCH(x || y);
+}
 
 ImplySemantics::ImplySemantics(): NormalSemantics("=>", TBOOL, {TBOOL, TBOOL}) {
 }
@@ -166,15 +226,24 @@ Data ImplySemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 }
 Data ImplySemantics::run(const ProgramList &sub_list, ExecuteInfo *info) {
     auto x = sub_list[0]->run(info);
-    if (!x.isTrue()) return Data(std::make_shared<BoolValue>(true));
+    if (x.isError()) return x;
+    if (!x.isTrue()) return BuildData(Bool, true);
     return sub_list[1]->run(info);
 }
+bool ImplySemantics::isLazy() const {
+    return true;
+}
+DataList ImplySemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    BOOL_BATCH(!x || y);
+}
 
 AllowFailSemantics::AllowFailSemantics(const PType& t, const Data &_d): Semantics("error->" + _d.toString()), TypedSemantics(t, {t}), d(_d) {
 }
 Data AllowFailSemantics::run(const std::vector<std::shared_ptr<Program> > &sub_list, ExecuteInfo *info) {
     try {
-        return sub_list[0]->run(info);
+        auto res = sub_list[0]->run(info);
+        if (res.isError()) return d;
+        return res;
     } catch (SemanticsError& e) {
         return d;
     }
@@ -3,9 +3,14 @@
 //
 
 #include "istool/basic/value.h"
+#include "istool/basic/data.h"
 #include "glog/logging.h"
 
 Value::Value() {}
+size_t Value::hash() const {
+    return std::hash<std::string>()(toString());
+}
+
 NullValue::NullValue() {}
 bool NullValue::equal(Value *value) const {
     auto* nv = dynamic_cast<NullValue*>(value);
@@ -14,6 +19,9 @@ bool NullValue::equal(Value *value) const {
 std::string NullValue::toString() const {
     return "null";
 }
+size_t NullValue::hash() const {
+    return Data().hash();
+}
 
 BoolValue::BoolValue(bool _w): w(_w){}
 bool BoolValue::equal(Value *value) const {
@@ -25,4 +33,44 @@ bool BoolValue::equal(Value *value) const {
 }
 std::string BoolValue::toString() const {
     return w ? "true" : "false";
-}
\ No newline at end of file
+}
+size_t BoolValue::hash() const {
+    return BuildData(Bool, w).hash();
+}
+
+IntValue::IntValue(int _w): w(_w) {
+}
+bool IntValue::equal(Value *value) const {
+    auto* iv = dynamic_cast<IntValue*>(value);
+    if (!iv) return false;
+    return iv->w == w;
+}
+std::string IntValue::toString() const {
+    return std::to_string(w);
+}
+std::string IntValue::toHaskell(bool in_result = false) const {
+    std::string res = "(" + toString() + ")";
+    // return "int" + res;
+    return res;
+}
+bool IntValue::leq(Value *value) const {
+    auto* iv = dynamic_cast<IntValue*>(value);
+    if (!iv) {
+        LOG(FATAL) << "Expect IntValue, but get " << value->toString();
+    }
+    return w <= iv->w;
+}
+size_t IntValue::hash() const {
+    return BuildData(Int, w).hash();
+}
+
+UnitValue::UnitValue() {}
+std::string UnitValue::toString() const {
+    return "unit";
+}
+bool UnitValue::equal(Value *value) const {
+    return dynamic_cast<UnitValue*>(value);
+}
+size_t UnitValue::hash() const {
+    return data::buildUnit().hash();
+}
@@ -0,0 +1,67 @@
+//
+// Created by pro on 2024/3/2.
+//
+
+#include "istool/basic/value_arena.h"
+#include <functional>
+#include <algorithm>
+
+namespace {
+    thread_local ValueArena* current_arena = nullptr;
+}
+
+ValueArena::ValueArena(size_t _chunk_size): chunk_id(-1), pos(0), chunk_size(_chunk_size) {
+}
+
+char *ValueArena::allocateChunk(size_t size) {
+    auto* chunk = new char[size];
+    chunk_list.emplace_back(chunk, size);
+    return chunk;
+}
+
+void *ValueArena::allocate(size_t size, size_t align) {
+    if (chunk_id >= 0) {
+        auto [chunk, capacity] = chunk_list[chunk_id];
+        size_t start = (pos + align - 1) / align * align;
+        if (start + size <= capacity) {
+            pos = start + size; return chunk + start;
+        }
+    }
+    // Move to the next chunk that is large enough, and allocate a new one if there is none.
+    for (++chunk_id; chunk_id < chunk_list.size(); ++chunk_id) {
+        if (chunk_list[chunk_id].second >= size) {
+            pos = size; return chunk_list[chunk_id].first;
+        }
+    }
+    auto* chunk = allocateChunk(std::max(size, chunk_size));
+    chunk_id = int(chunk_list.size()) - 1; pos = size;
+    return chunk;
+}
+
+bool ValueArena::contains(const void *ptr) const {
+    auto* p = static_cast<const char*>(ptr);
+    for (auto& [chunk, capacity]: chunk_list) {
+        if (std::less_equal<const char*>()(chunk, p) && std::less<const char*>()(p, chunk + capacity)) return true;
+    }
+    return false;
+}
+
+void ValueArena::reset() {
+    chunk_id = chunk_list.empty() ? -1 : 0; pos = 0;
+}
+
+ValueArena::~ValueArena() {
+    for (auto& [chunk, _]: chunk_list) delete[] chunk;
+}
+
+ValueArena* ValueArena::getCurrent() {
+    return current_arena;
+}
+
+ArenaScope::ArenaScope(const PValueArena &_arena): arena(_arena), pre(current_arena) {
+    current_arena = arena.get();
+}
+
+ArenaScope::~ArenaScope() {
+    current_arena = pre;
+}
@@ -36,9 +36,13 @@ FunctionContext invoker::multi::synthesis(Specification *spec, Verifier *v, cons
 
     MultiThreadTimeGuard* multi_guard;
     if (guard) multi_guard = new MultiThreadTimeGuard(*guard); else multi_guard = new MultiThreadTimeGuard(1e9);
+    // Each solver runs on its own fork of the env, so that the random streams are not shared among threads.
     std::vector<Solver*> solver_list;
+    std::vector<Specification*> spec_list;
     for (auto builder: builder_list) {
-        solver_list.push_back(builder(spec, v));
+        auto* thread_spec = new Specification(spec->info_list, spec->env->forkForThread(), spec->example_space);
+        spec_list.push_back(thread_spec);
+        solver_list.push_back(builder(thread_spec, v));
     }
 
     auto* fio = dynamic_cast<FiniteIOExampleSpace*>(spec->example_space.get());
@@ -68,7 +72,7 @@ FunctionContext invoker::multi::synthesis(Specification *spec, Verifier *v, cons
         thread_list.emplace_back(run, solver_list[i], i);
     }
     for (int i = 0; i < solver_list.size(); ++i) {
-        thread_list[i].join(); delete solver_list[i];
+        thread_list[i].join(); delete solver_list[i]; delete spec_list[i];
     }
     return res;
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ DEFINE_bool(autolabel, true, "Whether automatically generate annotations");
 DEFINE_bool(mark_rewrite, false, "Whether to mark the sketch holes.");
 DEFINE_bool(scalar, true, "Whether consider only scalar expressions when filling sketch holes");
 DEFINE_string(stage_output_file, "", "Only used in online demo");
+DEFINE_string(example_cache, "", "The directory caching the collected examples across runs, disabled when empty");
 
 int main(int argc, char** argv) {
     gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -50,6 +51,11 @@ int main(int argc, char** argv) {
                             [](){return new types::DefaultIncreTypeChecker();});
     ctx->ctx.printTypes();
     auto incre_info = incre::analysis::buildIncreInfo(prog.get(), env.get());
+    std::string example_cache_path;
+    if (!FLAGS_example_cache.empty()) {
+        example_cache_path = FLAGS_example_cache + "/" + incre_info->example_pool->getCacheKey() + ".pool";
+        if (incre_info->example_pool->loadCache(example_cache_path)) LOG(INFO) << "Examples loaded from " << example_cache_path;
+    }
 
     std::cout << std::endl << "Rewrite infos" << std::endl;
     for (auto& rewrite_info: incre_info->rewrite_info_list) {
@@ -85,6 +91,7 @@ int main(int argc, char** argv) {
 
     auto* solver = new IncreAutoLifterSolver(incre_info, env);
     auto res = solver->solve();
+    if (!example_cache_path.empty()) incre_info->example_pool->saveCache(example_cache_path);
 
     res.print();
     auto res_prog = rewriteWithIncreSolution(incre_info->program.get(), res, is_highlight_replace);
@@ -10,7 +10,10 @@ AnonymousSemantics::AnonymousSemantics(const SemanticsFunction &_f, const std::s
 AnonymousSemantics::AnonymousSemantics(const FullSemanticsFunction &_f, const std::string &_name): Semantics(_name) {
     f = [_f](const ProgramList& sub_list, ExecuteInfo* info) -> Data {
         DataList res;
-        for (const auto& sub: sub_list) res.push_back(sub->run(info));
+        for (const auto& sub: sub_list) {
+            res.push_back(sub->run(info));
+            if (res.back().isError()) return res.back();
+        }
         return _f(std::move(res), info);
     };
 }
@@ -13,7 +13,7 @@
 namespace {
     PProgram _buildChecker(const ExampleChecker& checker) {
         auto f = [checker](DataList&& inp, ExecuteInfo* info) {
-            auto res = checker(info->param_value);
+            auto res = checker(info->param_value.toDataList());
             return BuildData(Bool, res);
         };
         auto as = std::make_shared<AnonymousSemantics>(f, "checker");
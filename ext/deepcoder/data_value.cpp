@@ -32,6 +32,9 @@ bool ProductValue::equal(Value *v) const {
     }
     return true;
 }
+size_t ProductValue::hash() const {
+    return data::hashCombine(std::hash<std::string>()("prod"), data::hashDataList(elements));
+}
 
 SumValue::SumValue(int _id, const Data &_value, int _n): id(_id), value(_value), Value(), n(_n) {}
 std::string SumValue::toString() const {
@@ -42,6 +45,9 @@ bool SumValue::equal(Value *v) const {
     if (!sv) return false;
     return sv->id == id && sv->value == value;
 }
+size_t SumValue::hash() const {
+    return data::hashCombine(std::hash<int>()(id), value.hash());
+}
 
 ListValue::ListValue(const DataList &_value): value(_value), Value() {}
 std::string ListValue::toString() const {
@@ -59,6 +65,9 @@ bool ListValue::equal(Value *v) const {
         if (!(value[i] == dv->value[i])) return false;
     return true;
 }
+size_t ListValue::hash() const {
+    return data::hashCombine(std::hash<std::string>()("list"), data::hashDataList(value));
+}
 
 BTreeValue::BTreeValue(): Value() {}
 
@@ -74,6 +83,9 @@ bool BTreeInternalValue::equal(Value *v) const {
     if (!iv) return false;
     return iv->value == value && iv->l->equal(l.get()) && iv->r->equal(r.get());
 }
+size_t BTreeInternalValue::hash() const {
+    return data::hashCombine(data::hashCombine(value.hash(), l->hash()), r->hash());
+}
 
 BTreeLeafValue::BTreeLeafValue(const Data &_v): value(_v) {}
 std::string BTreeLeafValue::toString() const {
@@ -87,15 +99,18 @@ bool BTreeLeafValue::equal(Value *v) const {
     if (!lv) return false;
     return lv->value == value;
 }
+size_t BTreeLeafValue::hash() const {
+    return data::hashCombine(std::hash<std::string>()("leaf"), value.hash());
+}
 
 Data ext::ho::buildList(const DataList &content) {
-    return Data(std::make_shared<ListValue>(content));
+    return data::makeData<ListValue>(content);
 }
 Data ext::ho::buildProduct(const DataList &elements) {
-    return Data(std::make_shared<ProductValue>(elements));
+    return data::makeData<ProductValue>(elements);
 }
 Data ext::ho::buildSum(int id, const Data &value) {
-    return Data(std::make_shared<SumValue>(id, value));
+    return data::makeData<SumValue>(id, value);
 }
 
 DeepCoderValueTypeInfo::DeepCoderValueTypeInfo(TypeExtension *_ext): ext(_ext) {
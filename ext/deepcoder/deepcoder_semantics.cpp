@@ -47,7 +47,7 @@ Data ListSumSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     int sum = 0, inf_value = getIntValue(*inf);
     for (int i = 0; i < lv->value.size(); ++i) {
         sum += getIntValue(lv->value[i]);
-        if (std::abs(sum) > inf_value) throw SemanticsError();
+        if (std::abs(sum) > inf_value) return data::buildError();
     }
     return BuildData(Int, sum);
 }
@@ -62,7 +62,7 @@ Data ListLenSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 ListMaxSemantics::ListMaxSemantics(): NormalSemantics("maximum", TINT, {TINTLIST}) {}
 Data ListMaxSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* lv = _getList(inp_list[0]);
-    if (lv->value.empty()) throw SemanticsError();
+    if (lv->value.empty()) return data::buildError();
     int res = getIntValue(lv->value[0]);
     for (int i = 1; i < lv->value.size(); ++i) {
         res = std::max(res, getIntValue(lv->value[i]));
@@ -73,7 +73,7 @@ Data ListMaxSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 ListMinSemantics::ListMinSemantics(): NormalSemantics("minimum", TINT, {TINTLIST}) {}
 Data ListMinSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* lv = _getList(inp_list[0]);
-    if (lv->value.empty()) throw SemanticsError();
+    if (lv->value.empty()) return data::buildError();
     int res = getIntValue(lv->value[0]);
     for (int i = 1; i < lv->value.size(); ++i) {
         res = std::min(res, getIntValue(lv->value[i]));
@@ -84,7 +84,7 @@ Data ListMinSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 ListHeadSemantics::ListHeadSemantics(): NormalSemantics("head", TVARA, {TLISTA}) {}
 Data ListHeadSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* lv = _getList(inp_list[0]);
-    if (lv->value.empty()) throw SemanticsError();
+    if (lv->value.empty()) return data::buildError();
     return lv->value[0];
 }
 
@@ -92,7 +92,7 @@ ListLastSemantics::ListLastSemantics(): NormalSemantics("last", TVARA, {TLISTA})
 Data ListLastSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* lv = _getList(inp_list[0]);
     int len = lv->value.size();
-    if (!len) throw SemanticsError();
+    if (!len) return data::buildError();
     return lv->value[len - 1];
 }
 
@@ -101,7 +101,7 @@ Data ListAccessSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* lv = _getList(inp_list[0]);
     int len = lv->value.size(), pos = getIntValue(inp_list[1]);
     if (pos < 0) pos += len;
-    if (pos < 0 || pos >= len) throw SemanticsError();
+    if (pos < 0 || pos >= len) return data::buildError();
     return lv->value[pos];
 }
 
@@ -123,7 +123,9 @@ Data ListCountSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* sem = getSemantics(inp_list[1]).get();
     int res = 0;
     for (auto& d: lv->value) {
-        if (_invoke(sem, {d}, info).isTrue()) ++res;
+        auto flag = _invoke(sem, {d}, info);
+        if (flag.isError()) return flag;
+        if (flag.isTrue()) ++res;
     }
     return BuildData(Int, res);
 }
@@ -196,6 +198,7 @@ Data ListMapSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     DataList res(lv->value.size());
     for (int i = 0; i < lv->value.size(); ++i) {
         res[i] = _invoke(sem, {lv->value[i]}, info);
+        if (res[i].isError()) return res[i];
     }
     return buildList(res);
 }
@@ -206,9 +209,9 @@ Data ListFilterSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* lv = _getList(inp_list[1]);
     DataList res;
     for (int i = 0; i < lv->value.size(); ++i) {
-        if (_invoke(sem, {lv->value[i]}, info).isTrue()) {
-            res.push_back(lv->value[i]);
-        }
+        auto flag = _invoke(sem, {lv->value[i]}, info);
+        if (flag.isError()) return flag;
+        if (flag.isTrue()) res.push_back(lv->value[i]);
     }
     return buildList(res);
 }
@@ -221,6 +224,7 @@ Data ListZipWithSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     DataList res;
     for (int i = 0; i < x->value.size() && i < y->value.size(); ++i) {
         res.push_back(_invoke(sem, {x->value[i], y->value[i]}, info));
+        if (res.back().isError()) return res.back();
     }
     return buildList(res);
 }
@@ -228,11 +232,12 @@ Data ListZipWithSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 ListScanlSemantics::ListScanlSemantics(): NormalSemantics("scanl", TLISTA, {_getArrowType({TVARA, TVARA}, TVARA), TLISTA}) {}
 Data ListScanlSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* sem = getSemantics(inp_list[0]).get(); auto* lv = _getList(inp_list[1]);
-    if (lv->value.empty()) throw SemanticsError();
+    if (lv->value.empty()) return data::buildError();
     auto current = lv->value[0];
     DataList res = {current};
     for (int i = 1; i < lv->value.size(); ++i) {
         current = _invoke(sem, {current, lv->value[i]}, info);
+        if (current.isError()) return current;
         res.push_back(current);
     }
     return BuildData(List, res);
@@ -241,11 +246,12 @@ Data ListScanlSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
 ListScanrSemantics::ListScanrSemantics(): NormalSemantics("scanr", TLISTA, {_getArrowType({TVARA, TVARA}, TVARA), TLISTA}) {}
 Data ListScanrSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     auto* sem = getSemantics(inp_list[0]).get(); auto* lv = _getList(inp_list[1]);
-    if (lv->value.empty()) throw SemanticsError();
+    if (lv->value.empty()) return data::buildError();
     int n = lv->value.size(); auto current = lv->value[n - 1];
     DataList res = {current};
     for (int i = n - 2; i >= 0; --i) {
         current = _invoke(sem, {lv->value[i], current}, info);
+        if (current.isError()) return current;
         res.push_back(current);
     }
     std::reverse(res.begin(), res.end());
@@ -294,6 +300,7 @@ Data ListFoldSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     Data s = inp_list[1]; auto* lv = _getList(inp_list[2]);
     for (int i = lv->value.size(); i; --i) {
         s = _invoke(f, {lv->value[i - 1], s}, info);
+        if (s.isError()) return s;
     }
     return s;
 }
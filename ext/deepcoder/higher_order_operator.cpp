@@ -84,6 +84,7 @@ Data TriangleSemantics::run(DataList &&func_list, ExecuteInfo *info) {
         for (auto& func: func_list) {
             auto sem = ext::ho::getSemantics(func);
             res.push_back(sem->run(sub_list, info));
+            if (res.back().isError()) return res.back();
         }
         return BuildData(Product, res);
     };
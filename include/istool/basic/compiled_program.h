@@ -0,0 +1,55 @@
+//
+// Created by pro on 2024/3/5.
+//
+
+#ifndef ISTOOL_COMPILED_PROGRAM_H
+#define ISTOOL_COMPILED_PROGRAM_H
+
+#include "program.h"
+
+enum class InstructionType {
+    PARAM, CONST, INVOKE, TREE
+};
+
+struct Instruction {
+    InstructionType type;
+    int id; // The parameter index for PARAM, and the number of arguments for INVOKE.
+    Data w; // The constant for CONST.
+    FullExecutedSemantics* semantics; // The semantics for INVOKE.
+    Program* program; // The program evaluated via Program::run for TREE.
+    DataList arg_buffer;
+    Instruction(InstructionType _type, int _id, const Data& _w, FullExecutedSemantics* _semantics, Program* _program);
+};
+
+/**
+ * A program lowered into a postfix instruction list. Params, consts and fully executed semantics are flattened.
+ * A lazy semantics (e.g., ite) is evaluated via Program::run on a shadow node whose sub-programs are compiled
+ * separately, and the sub-programs rooted at other semantics are evaluated in the tree form.
+ * The value stack and the argument buffers are reused among runs, so a CompiledProgram must not be shared by threads.
+ */
+class CompiledProgram {
+    PProgram source;
+    std::vector<Instruction> instruction_list;
+    ProgramList shadow_list;
+    DataList stack;
+    void compile(Program* program);
+public:
+    CompiledProgram(const PProgram& _source);
+    Data run(ExecuteInfo* info);
+    Program* getSource() const;
+    ~CompiledProgram() = default;
+};
+
+typedef std::shared_ptr<CompiledProgram> PCompiledProgram;
+
+class CompiledSemantics: public Semantics {
+public:
+    PCompiledProgram program;
+    CompiledSemantics(const PCompiledProgram& _program);
+    virtual Data run(const ProgramList& sub_list, ExecuteInfo* info);
+    virtual std::string buildProgramString(const std::vector<std::string>& sub_exp);
+    virtual uint64_t buildFingerprint(const std::vector<uint64_t>& sub_list);
+    virtual ~CompiledSemantics() = default;
+};
+
+#endif //ISTOOL_COMPILED_PROGRAM_H
@@ -7,36 +7,124 @@
 
 #include <memory>
 #include <vector>
+#include <unordered_set>
 #include "value.h"
+#include "value_arena.h"
+
+/**
+ * Small scalars (null, int, bool and unit) are stored inline in Data, and only the other values are stored as a
+ * shared PValue. Data::get() still returns a Value* for inlined scalars: bool, null, unit and ints in a small range
+ * are mapped to shared constant objects, and other ints are boxed on demand.
+ *
+ * An ERROR Data denotes a failed evaluation. It is propagated through Program::run without throwing, and accessing its
+ * content via get() throws SemanticsError.
+ */
+enum class DataKind {
+    NONE, INT, BOOL, UNIT, VALUE, ERROR
+};
+
+class Data;
+
+namespace data {
+    Data buildInt(int w);
+    Data buildBool(bool w);
+    Data buildUnit();
+    Data buildError();
+}
 
 class Data {
+    DataKind kind;
+    int w;
+    mutable PValue value;
+    Data(DataKind _kind, int _w);
+    Value* getBoxedValue() const;
 public:
-    PValue value;
-
     Data();
     Data(PValue&& _value);
+    Data(const Data& d);
+    Data(Data&& d) noexcept;
+    Data& operator = (const Data& d);
+    Data& operator = (Data&& d) noexcept;
 
     std::string toString() const;
     bool operator == (const Data& d) const;
     bool operator <= (const Data& d) const;
     bool operator < (const Data& d) const;
+    // Structural hash, consistent with operator ==.
+    size_t hash() const;
+    // Whether the two Data share the same representation. For Data interned in the same DataHashConsTable, this is
+    // equivalent to operator == but takes O(1) time.
+    bool isIdentical(const Data& d) const;
     Value* get() const;
     bool isTrue() const;
     bool isNull() const;
+    bool isError() const;
+
+    DataKind getKind() const;
+    bool isInlinedInt() const;
+    int getInlinedInt() const;
 
     ~Data() = default;
+
+    friend Data data::buildInt(int w);
+    friend Data data::buildBool(bool w);
+    friend Data data::buildUnit();
+    friend Data data::buildError();
 };
 
-#define BuildData(Type, w) Data(std::make_shared<Type ## Value>(w))
+namespace data {
+    // Build a value in the arena of the current ArenaScope if there is one, and on the heap otherwise.
+    template<class T, class... Args> Data makeData(Args&&... args) {
+        auto* arena = ValueArena::getCurrent();
+        if (arena) return Data(std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...));
+        return Data(std::make_shared<T>(std::forward<Args>(args)...));
+    }
+
+    template<class T> struct DataBuilder {
+        template<class... Args> static Data build(Args&&... args) {
+            return makeData<T>(std::forward<Args>(args)...);
+        }
+    };
+    template<> struct DataBuilder<IntValue> {
+        static Data build(int w) {return buildInt(w);}
+    };
+    template<> struct DataBuilder<BoolValue> {
+        static Data build(bool w) {return buildBool(w);}
+    };
+}
+
+#define BuildData(Type, w) data::DataBuilder<Type ## Value>::build(w)
 
 typedef std::vector<Data> DataList;
 typedef std::vector<DataList> DataStorage;
 
 namespace data {
+    size_t hashCombine(size_t seed, size_t value);
+    size_t hashDataList(const DataList& data_list);
+
+    struct DataHash {
+        size_t operator () (const Data& d) const {return d.hash();}
+    };
+    struct DataListHash {
+        size_t operator () (const DataList& data_list) const {return hashDataList(data_list);}
+    };
+
     std::string dataList2String(const DataList& data_list);
     DataList concatDataList(const DataList& x, const DataList& y);
     DataStorage cartesianProduct(const DataStorage& separate_data);
 }
 
+/**
+ * A hash-consing table. intern() returns the canonical copy of a value, such that all structurally equal values
+ * interned in the same table share one PValue and can be compared by Data::isIdentical.
+ */
+class DataHashConsTable {
+    std::unordered_set<Data, data::DataHash> table;
+public:
+    Data intern(const Data& d);
+    DataList intern(const DataList& data_list);
+    int size() const;
+    void clear();
+};
 
 #endif //ISTOOL_DATA_H
@@ -8,21 +8,47 @@
 #include "semantics.h"
 #include <unordered_map>
 #include <random>
+#include <atomic>
+#include <shared_mutex>
+
+class CompiledProgram;
 
 class Extension {
 public:
     virtual ~Extension() = default;
 };
 
+/**
+ * The configuration of an Env is shared with its forks and guarded by a lock, so it can be read from several
+ * threads. The constants, the semantics and the execute info builder should be set before other threads start.
+ * The random engine is not shared: each thread should draw from its own fork (see Env::forkForThread).
+ */
 class Env {
-    std::unordered_map<std::string, Data*> const_pool;
-    std::unordered_map<std::string, DataList*> const_list_pool;
-    std::unordered_map<std::string, Extension*> extension_pool;
-    std::unordered_map<std::string, PSemantics> semantics_pool;
-    ExecuteInfoBuilder* info_builder;
+    struct EnvState {
+        std::shared_mutex lock;
+        std::unordered_map<std::string, Data*> const_pool;
+        std::unordered_map<std::string, DataList*> const_list_pool;
+        std::unordered_map<std::string, Extension*> extension_pool;
+        std::unordered_map<std::string, PSemantics> semantics_pool;
+        ExecuteInfoBuilder* info_builder = nullptr;
+        int info_builder_id = -1;
+        ~EnvState();
+    };
+    std::shared_ptr<EnvState> state;
+    int seed, evaluation_fuel;
+    std::atomic<int> fork_num;
+    Env(const std::shared_ptr<EnvState>& _state, int _seed);
+    // ExecuteInfo objects are recycled via a per-thread pool, so that a steady-state execution does not allocate.
+    ExecuteInfo* acquireInfo(const ParamView& param, const FunctionContext& ctx);
+    void releaseInfo(ExecuteInfo* info);
 public:
     std::minstd_rand random_engine;
     Env();
+    Env(const Env&) = delete;
+    // Build an env sharing the configuration of this env, whose random engine is seeded deterministically from the
+    // seed of this env and the number of previous forks. Forks are cheap, and should be built in a fixed order
+    // (e.g., before starting the threads) for reproducible runs.
+    std::shared_ptr<Env> forkForThread();
 
     Data* getConstRef(const std::string& name, const Data& default_value = {});
     void setConst(const std::string& name, const Data& value);
@@ -38,14 +64,40 @@ public:
 
     void setExecuteInfoBuilder(ExecuteInfoBuilder* builder);
     Data run(Program* program, const DataList& param_list, const FunctionContext &ctx={});
+    Data run(CompiledProgram* program, const DataList& param_list, const FunctionContext &ctx={});
+    // The non-throwing versions of run, where a failed evaluation results in an error Data (see Data::isError).
+    Data tryRun(Program* program, const DataList& param_list, const FunctionContext &ctx={});
+    Data tryRun(CompiledProgram* program, const DataList& param_list, const FunctionContext &ctx={});
+    // The versions of run taking a view, which avoid building a concatenated parameter list.
+    Data run(Program* program, const ParamView& param, const FunctionContext &ctx={});
+    Data run(CompiledProgram* program, const ParamView& param, const FunctionContext &ctx={});
+    Data tryRun(Program* program, const ParamView& param, const FunctionContext &ctx={});
+    Data tryRun(CompiledProgram* program, const ParamView& param, const FunctionContext &ctx={});
+    // Run a program on a list of examples at once. A SemanticsError is thrown if the program fails on any of them.
+    DataList runBatch(Program* program, const DataStorage& example_list, const FunctionContext &ctx={});
     ExecuteInfoBuilder* getExecuteInfoBuilder();
+    // The number of steps available to each execution started by run, tryRun and runBatch, where each program node
+    // takes one step. A negative number (the default) means no limit. An execution running out of fuel fails with a
+    // SemanticsError. The fuel is not shared with forks.
+    void setEvaluationFuel(int fuel);
+    int getEvaluationFuel() const;
 
     int setRandomSeed(int seed);
+    int getRandomSeed() const;
     ~Env();
 };
 
 typedef std::shared_ptr<Env> PEnv;
 
+// Set the evaluation fuel of an env while the scope is alive.
+class EvaluationFuelScope {
+    Env* env;
+    int pre_fuel;
+public:
+    EvaluationFuelScope(Env* _env, int fuel);
+    ~EvaluationFuelScope();
+};
+
 namespace env {
     void setTimeSeed(Env* env);
 }
@@ -12,19 +12,47 @@ class Program;
 class FunctionContext: public std::unordered_map<std::string, std::shared_ptr<Program>> {
 public:
     std::string toString() const;
+    uint64_t getFingerprint() const;
+};
+
+/**
+ * A read-only view of a parameter list stored in two consecutive segments (e.g., local inputs followed by global
+ * inputs), so that the parameters can be passed without concatenating them. A view does not own the values: the
+ * underlying lists must outlive it.
+ */
+class ParamView {
+    const Data* local;
+    const Data* global;
+    int local_size, global_size;
+public:
+    ParamView();
+    ParamView(const DataList& param_list);
+    ParamView(const DataList& local_list, const DataList& global_list);
+    ParamView(const Data* _local, int _local_size, const Data* _global, int _global_size);
+    const Data& operator [] (int id) const {
+        return id < local_size ? local[id] : global[id - local_size];
+    }
+    int size() const;
+    DataList toDataList() const;
 };
 
 class ExecuteInfo {
 public:
-    DataList param_value;
+    ParamView param_value;
     FunctionContext func_context;
-    ExecuteInfo(const DataList& _param_value, const FunctionContext& _context);
+    // The number of remaining evaluation steps, or a negative number for no limit. See Env::setEvaluationFuel.
+    int fuel;
+    ExecuteInfo(const ParamView& _param_value, const FunctionContext& _context);
+    // Consume one step, where a SemanticsError is thrown if no step remains.
+    void consumeFuel();
     virtual ~ExecuteInfo() = default;
 };
 
 class ExecuteInfoBuilder {
 public:
-    virtual ExecuteInfo* buildInfo(const DataList& _param_value, const FunctionContext& ctx);
+    virtual ExecuteInfo* buildInfo(const ParamView& _param_value, const FunctionContext& ctx);
+    // Rebind an info built by this builder to new parameters, such that the info can be reused among executions.
+    virtual void resetInfo(ExecuteInfo* info, const ParamView& _param_value, const FunctionContext& ctx);
     virtual ~ExecuteInfoBuilder() = default;
 };
 
@@ -14,13 +14,19 @@ typedef std::vector<PProgram> ProgramList;
 typedef std::vector<ProgramList> ProgramStorage;
 
 class Program {
+    mutable uint64_t fingerprint; // 0 if not computed yet.
 public:
     PSemantics semantics;
     ProgramList sub_list;
     Program(const PSemantics& _semantics, const ProgramList& _sub_list);
     int size() const;
     Data run(ExecuteInfo* info) const;
+    // Run on a batch of executions at once. A SemanticsError is thrown if the program fails on any of them.
+    DataList runBatch(const std::vector<ExecuteInfo*>& info_list) const;
     std::string toString() const;
+    // A 64-bit structural hash computed on the first request, which should replace toString() as the key of
+    // caches. A program must not be modified after its fingerprint is taken.
+    uint64_t getFingerprint() const;
     virtual ~Program() = default;
 };
 
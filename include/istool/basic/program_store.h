@@ -0,0 +1,64 @@
+//
+// Created by pro on 2024/3/8.
+//
+
+#ifndef ISTOOL_PROGRAM_STORE_H
+#define ISTOOL_PROGRAM_STORE_H
+
+#include "env.h"
+#include "program.h"
+#include <unordered_map>
+
+/**
+ * A hash-consing store of programs. Structurally identical programs (the same semantics name on identical
+ * sub-programs) are interned as a single node with a stable id, and thus programs sharing subterms form a DAG.
+ */
+class ProgramStore {
+    struct NodeKey {
+        std::string name;
+        std::vector<int> sub_id_list;
+        bool operator == (const NodeKey& key) const;
+    };
+    struct NodeKeyHash {
+        size_t operator () (const NodeKey& key) const;
+    };
+    std::unordered_map<NodeKey, int, NodeKeyHash> node_map;
+    // Maps the program objects stored as nodes to their ids, such that the sub-programs shared by pointer
+    // are located without comparing their structures.
+    std::unordered_map<Program*, int> program_map;
+public:
+    ProgramList node_list;
+    std::vector<std::vector<int>> sub_id_storage;
+    // Return the id of the node structurally identical to the program, and insert the node if there is none.
+    int insert(const PProgram& program);
+    int size() const;
+    void clear();
+};
+
+/**
+ * Results of interned programs on a fixed list of examples, keyed by (node id, example id). A program built on
+ * cached sub-programs is evaluated by applying only its root semantics to the cached results of its children.
+ */
+class ProgramEvalCache {
+    Env* env;
+    DataStorage example_list;
+    std::vector<ExecuteInfo*> info_list;
+    std::vector<DataList> result_storage;
+    std::vector<bool> is_evaluated;
+    DataList runRoot(Program* program, const std::vector<int>& sub_id_list);
+    void extend();
+public:
+    ProgramStore store;
+    ProgramEvalCache(const DataStorage& _example_list, Env* _env);
+    ProgramEvalCache(const ProgramEvalCache&) = delete;
+    // Evaluate a program on all examples. Its sub-programs are interned and cached, but the program itself is not.
+    DataList run(const PProgram& program);
+    // Intern a program together with its results (e.g., returned by run), so that later programs can reuse them.
+    int insert(const PProgram& program, const DataList& result);
+    // The results of an interned node, which are evaluated when first requested.
+    const DataList& getResult(int node_id);
+    int getExampleNum() const;
+    ~ProgramEvalCache();
+};
+
+#endif //ISTOOL_PROGRAM_STORE_H
@@ -7,6 +7,7 @@
 
 #include <exception>
 #include <unordered_map>
+#include <cstdint>
 #include "data.h"
 #include "execute_info.h"
 #include "z3++.h"
@@ -27,6 +28,8 @@ public:
     virtual Data run(const std::vector<std::shared_ptr<Program>>& sub_list, ExecuteInfo* info) = 0;
     virtual std::string buildProgramString(const std::vector<std::string>& sub_exp);
     virtual std::string buildProgramStringToHaskell(const std::vector<std::string>& sub_exp);
+    // The structural fingerprint of a program rooted at this semantics, in parallel with buildProgramString.
+    virtual uint64_t buildFingerprint(const std::vector<uint64_t>& sub_list);
     virtual std::string getName();
     virtual ~Semantics() = default;
 };
@@ -45,6 +48,12 @@ public:
     FullExecutedSemantics(const std::string& name);
     Data run(const std::vector<std::shared_ptr<Program>>& sub_list, ExecuteInfo* info);
     virtual Data run(DataList&& inp_list, ExecuteInfo* info) = 0;
+    // Whether run(sub_list, info) is overridden to skip some sub-programs. Lazy semantics are not flattened by
+    // CompiledProgram.
+    virtual bool isLazy() const;
+    // Run on a batch of executions, where inp_list[i] is the column of the i-th argument over info_list. The default
+    // implementation runs the executions one by one.
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     virtual ~FullExecutedSemantics() = default;
 };
 
@@ -77,6 +86,7 @@ public:
     DirectSemantics();
     virtual Data run(DataList&&, ExecuteInfo* info);
     virtual std::string buildProgramString(const std::vector<std::string>& sub_exp);
+    virtual uint64_t buildFingerprint(const std::vector<uint64_t>& sub_list);
     ~DirectSemantics() = default;
 };
 
@@ -94,6 +104,10 @@ public:
     virtual ~TypedInvokeSemantics() = default;
 };
 
+namespace semantics {
+    uint64_t combineFingerprint(uint64_t seed, uint64_t value);
+}
+
 #define DefineNormalSemantics(name) \
 class name ## Semantics : public NormalSemantics { \
 public: \
@@ -102,6 +116,15 @@ public: \
     ~name ## Semantics() = default; \
 };
 
+#define DefineBatchedNormalSemantics(name) \
+class name ## Semantics : public NormalSemantics { \
+public: \
+    name ## Semantics(); \
+    virtual Data run(DataList &&inp_list, ExecuteInfo *info); \
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list); \
+    ~name ## Semantics() = default; \
+};
+
 // basic logic semantics
 DefineNormalSemantics(Not)
 
@@ -110,6 +133,8 @@ public:
     AndSemantics();
     virtual Data run(DataList &&inp_list, ExecuteInfo* info);
     virtual Data run(const std::vector<std::shared_ptr<Program>>& sub_list, ExecuteInfo *info);
+    virtual bool isLazy() const;
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~AndSemantics() = default;
 };
 
@@ -118,6 +143,8 @@ public:
     OrSemantics();
     virtual Data run(DataList &&inp_list, ExecuteInfo* info);
     virtual Data run(const std::vector<std::shared_ptr<Program>>& sub_list, ExecuteInfo *info);
+    virtual bool isLazy() const;
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~OrSemantics() = default;
 };
 
@@ -126,6 +153,8 @@ public:
     ImplySemantics();
     virtual Data run(DataList &&inp_list, ExecuteInfo* info);
     virtual Data run(const std::vector<std::shared_ptr<Program>>& sub_list, ExecuteInfo *info);
+    virtual bool isLazy() const;
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~ImplySemantics() = default;
 };
 
@@ -15,6 +15,8 @@ public:
     virtual ~Value() = default;
     virtual std::string toString() const = 0;
     virtual bool equal(Value* value) const = 0;
+    // A hash consistent with equal(). The default implementation hashes toString().
+    virtual size_t hash() const;
 };
 
 typedef std::shared_ptr<Value> PValue;
@@ -29,6 +31,7 @@ public:
     NullValue();
     virtual std::string toString() const;
     virtual bool equal(Value* value) const;
+    virtual size_t hash() const;
 };
 
 class BoolValue: public Value {
@@ -37,6 +40,26 @@ public:
     BoolValue(bool _w);
     virtual std::string toString() const;
     virtual bool equal(Value* value) const;
+    virtual size_t hash() const;
+};
+
+class IntValue: public Value, public ComparableValue {
+public:
+    int w;
+    IntValue(int _w);
+    virtual std::string toString() const;
+    virtual std::string toHaskell(bool in_result) const;
+    virtual bool equal(Value* value) const;
+    virtual bool leq(Value* value) const;
+    virtual size_t hash() const;
+};
+
+class UnitValue: public Value {
+public:
+    UnitValue();
+    virtual std::string toString() const;
+    virtual bool equal(Value* value) const;
+    virtual size_t hash() const;
 };
 
 #endif //ISTOOL_VALUE_H
@@ -0,0 +1,56 @@
+//
+// Created by pro on 2024/3/2.
+//
+
+#ifndef ISTOOL_VALUE_ARENA_H
+#define ISTOOL_VALUE_ARENA_H
+
+#include <memory>
+#include <vector>
+
+/**
+ * A region allocator for short-lived values. Memory is bump-allocated from large chunks and never returned
+ * individually: the chunks are released together when the arena is destroyed. Values allocated from an arena do
+ * not keep it alive, and thus the owner of the arena must ensure that none of them outlives it or its reset().
+ */
+class ValueArena {
+    std::vector<std::pair<char*, size_t>> chunk_list;
+    int chunk_id;
+    size_t pos, chunk_size;
+    char* allocateChunk(size_t size);
+public:
+    ValueArena(size_t _chunk_size = 1 << 16);
+    void* allocate(size_t size, size_t align);
+    bool contains(const void* ptr) const;
+    // Reuse all chunks from the beginning. Must only be invoked when no value allocated from this arena is alive.
+    void reset();
+    ~ValueArena();
+
+    static ValueArena* getCurrent();
+};
+
+typedef std::shared_ptr<ValueArena> PValueArena;
+
+// An allocator for std::allocate_shared, which refers to the arena without owning it.
+template<class T> class ArenaAllocator {
+public:
+    typedef T value_type;
+    ValueArena* arena;
+    ArenaAllocator(ValueArena* _arena): arena(_arena) {}
+    template<class U> ArenaAllocator(const ArenaAllocator<U>& allocator): arena(allocator.arena) {}
+    T* allocate(size_t n) {return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));}
+    void deallocate(T* ptr, size_t n) {}
+    template<class U> bool operator == (const ArenaAllocator<U>& allocator) const {return arena == allocator.arena;}
+    template<class U> bool operator != (const ArenaAllocator<U>& allocator) const {return arena != allocator.arena;}
+};
+
+// Values built via data::makeData in the current thread are allocated from the arena while the scope is alive.
+class ArenaScope {
+    PValueArena arena;
+    ValueArena* pre;
+public:
+    ArenaScope(const PValueArena& _arena);
+    ~ArenaScope();
+};
+
+#endif //ISTOOL_VALUE_ARENA_H
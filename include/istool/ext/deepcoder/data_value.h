@@ -17,6 +17,7 @@ public:
     virtual ~ProductValue() = default;
     virtual std::string toString() const;
     virtual bool equal(Value* v) const;
+    virtual size_t hash() const;
 };
 
 class SumValue: public Value {
@@ -28,6 +29,7 @@ public:
     virtual ~SumValue() = default;
     virtual std::string toString() const;
     virtual bool equal(Value* v) const;
+    virtual size_t hash() const;
 };
 
 class ListValue: public Value {
@@ -38,6 +40,7 @@ public:
     virtual std::string toString() const;
     virtual std::string toHaskell(bool in_result) const;
     virtual bool equal(Value* v) const;
+    virtual size_t hash() const;
 };
 
 class BTreeValue: public Value {
@@ -56,6 +59,7 @@ public:
     virtual std::string toString() const;
     virtual std::string toHaskell(bool in_result) const;
     virtual bool equal(Value* v) const;
+    virtual size_t hash() const;
 };
 
 class BTreeLeafValue: public BTreeValue {
@@ -66,6 +70,7 @@ public:
     virtual std::string toString() const;
     virtual std::string toHaskell(bool in_result) const;
     virtual bool equal(Value* v) const;
+    virtual size_t hash() const;
 };
 
 class DeepCoderValueTypeInfo: public ValueTypeInfo {
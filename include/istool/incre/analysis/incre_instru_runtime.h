@@ -9,15 +9,27 @@
 #include "istool/basic/example_sampler.h"
 #include "incre_instru_types.h"
 #include <random>
+#include <mutex>
+#include <atomic>
 #include <unordered_set>
 
 namespace incre::example {
+    extern const std::string KIsUseArenaName;
+    extern const std::string KIsExactDedupName;
+    extern const std::string KIsUseSmallScopeName;
+    extern const std::string KIsUseUniformSampleName;
+    extern const std::string KEnumerateLimitName;
+
     struct IncreExampleData {
         int rewrite_id;
         DataList local_inputs, global_inputs;
         Data oup;
+        // Set only when some values (e.g., closures) are still allocated from an arena, which is then kept alive here.
+        PValueArena arena;
         IncreExampleData(int _rewrite_id, const DataList& _local, const DataList& _global, const Data& _oup);
         std::string toString() const;
+        size_t hash() const;
+        bool operator == (const IncreExampleData& example) const;
         virtual ~IncreExampleData() = default;
     };
 
@@ -26,6 +38,51 @@ namespace incre::example {
     typedef std::shared_ptr<IncreExampleData> IncreExample;
     typedef std::vector<IncreExample> IncreExampleList;
 
+    struct IncreExampleHash {
+        size_t operator () (const IncreExample& example) const {return example->hash();}
+    };
+    struct IncreExampleEqual {
+        bool operator () (const IncreExample& x, const IncreExample& y) const {return *x == *y;}
+    };
+    typedef std::unordered_set<IncreExample, IncreExampleHash, IncreExampleEqual> IncreExampleSet;
+
+    /**
+     * A 128-bit key of an example. low and high combine the structural hashes of the components independently, so
+     * two different examples get the same key only if both combinations collide or their component hashes collide.
+     */
+    struct IncreExampleKey {
+        size_t low, high;
+        IncreExampleKey(IncreExampleData* example);
+        bool operator == (const IncreExampleKey& key) const {return low == key.low && high == key.high;}
+    };
+    struct IncreExampleKeyHash {
+        size_t operator () (const IncreExampleKey& key) const {return key.low;}
+    };
+
+    /**
+     * A set of examples deduplicated by IncreExampleKey, which can be accessed by several threads. The keys are
+     * partitioned into shards, each guarded by its own lock. When is_exact is set, the examples are stored as well and
+     * those with the same key are further compared structurally; otherwise, only the keys are stored.
+     */
+    class IncreExampleDedupSet {
+    private:
+        struct alignas(64) Shard {
+            std::mutex lock;
+            std::unordered_multimap<IncreExampleKey, IncreExample, IncreExampleKeyHash> example_map;
+        };
+        bool is_exact;
+        std::vector<Shard> shard_list;
+        Shard& getShard(const IncreExampleKey& key);
+    public:
+        IncreExampleDedupSet(bool _is_exact, int shard_num = 64);
+        bool contains(const IncreExampleKey& key, IncreExampleData* example);
+        // Insert example and return whether it is new.
+        bool insert(const IncreExampleKey& key, const IncreExample& example);
+        int size();
+        // An estimation of the memory used by the set in bytes, excluding the stored examples.
+        size_t getMemoryCost();
+    };
+
     class IncreDataGenerator {
     public:
         Env* env;
@@ -35,12 +92,22 @@ namespace incre::example {
         Data getRandomBool();
         IncreDataGenerator(Env* _env, const std::unordered_map<std::string, CommandDef*>& _cons_map);
         virtual Data getRandomData(const syntax::Ty& type) = 0;
+        // Generate values for a list of types, which are used together as an input.
+        virtual DataList getRandomDataList(const syntax::TyList& type_list);
+        // Build a generator of the same configuration drawing randoms from _env, which can be used by another thread.
+        virtual IncreDataGenerator* fork(Env* _env) const = 0;
+        // Describe the kind and the settings of the generator, which determine the distribution of generated values.
+        virtual std::string getSettingDescription() const;
+        // The progress of a deterministic generation shared by forks (e.g., enumeration cursors), which is saved with
+        // cached examples and restored in a later run, such that the run continues from where the cached one stopped.
+        virtual std::vector<std::pair<std::string, long long>> getProgress() const;
+        virtual void restoreProgress(const std::vector<std::pair<std::string, long long>>& progress);
         virtual ~IncreDataGenerator() = default;
     };
 
     std::unordered_map<std::string, CommandDef*> extractConsMap(IncreProgramData* program);
 
-    typedef std::variant<std::pair<std::string, syntax::Ty>, std::vector<int>> SizeSplitScheme;
+    typedef std::variant<std::pair<int, syntax::Ty>, std::vector<int>> SizeSplitScheme;
     typedef std::vector<SizeSplitScheme> SizeSplitList;
 
     class SizeSafeValueGenerator: public IncreDataGenerator {
@@ -49,19 +116,107 @@ namespace incre::example {
         SizeSplitList* getPossibleSplit(syntax::TypeData* type, int size);
         SizeSafeValueGenerator(Env* _env, const std::unordered_map<std::string, CommandDef*>& _ind_cons_map);
         virtual Data getRandomData(const syntax::Ty& type);
+        virtual IncreDataGenerator* fork(Env* _env) const;
         virtual ~SizeSafeValueGenerator();
     };
 
+    /**
+     * A generator sampling values uniformly among all values within KSizeLimit. Types are interned into ids, and the
+     * number of values is precomputed for each type id and size, such that each size and each scheme is chosen with
+     * probability proportional to the number of its values.
+     */
+    class UniformValueGenerator: public SizeSafeValueGenerator {
+    private:
+        struct CountEntry {
+            SizeSplitList* split_list = nullptr;
+            double num = 0;
+            // The number of values and the ids of the content types (only for inductive types) of each scheme.
+            std::vector<double> scheme_num;
+            std::vector<int> scheme_content;
+        };
+        std::unordered_map<syntax::TypeData*, int> type_id_map;
+        std::unordered_map<std::string, int> type_name_map;
+        // The representative type of each id.
+        syntax::TyList type_list;
+        // The other types mapped to ids, which are kept alive such that their addresses are not reused.
+        syntax::TyList alias_type_list;
+        // The ids of the fields of tuples and the body of compress types.
+        std::vector<std::vector<int>> sub_type_list;
+        std::vector<std::vector<CountEntry>> count_table;
+        // The distribution of the sizes of the values sampled for each type id.
+        std::unordered_map<int, std::discrete_distribution<int>> size_dist_map;
+        int getTypeId(const syntax::Ty& type);
+        CountEntry& getCountEntry(int type_id, int size);
+        Data sample(int type_id, int size);
+    public:
+        UniformValueGenerator(Env* _env, const std::unordered_map<std::string, CommandDef*>& _cons_map);
+        // The number of values of type in the given size.
+        double getValueNum(const syntax::Ty& type, int size);
+        virtual Data getRandomData(const syntax::Ty& type);
+        virtual IncreDataGenerator* fork(Env* _env) const;
+        virtual ~UniformValueGenerator() = default;
+    };
+
+    /**
+     * A generator enumerating inputs in increasing size, where integers range over [KIntMin, KIntMax] and the values
+     * used together as an input are enumerated jointly. Once a size level has more than KEnumerateLimit values or the
+     * size exceeds KSizeLimit, inputs are sampled as SizeSafeValueGenerator does. Forks share the enumeration, such
+     * that the threads split the enumerated inputs without overlapping.
+     */
+    class SmallScopeValueGenerator: public SizeSafeValueGenerator {
+    public:
+        struct EnumerationState {
+            std::mutex lock;
+            // The number of inputs taken from the enumeration of each list of types.
+            std::unordered_map<std::string, std::atomic<long long>> cursor_map;
+        };
+    private:
+        std::shared_ptr<EnumerationState> state;
+        std::unordered_map<std::string, long long> count_map;
+        std::atomic<long long>& getCursor(const std::string& feature);
+    public:
+        int KEnumerateLimit;
+        // The number of values of type in the given size, which is saturated at a number larger than KEnumerateLimit.
+        long long getValueNum(syntax::TypeData* type, int size);
+        // The index-th value of type in the given size.
+        Data getValue(syntax::TypeData* type, int size, long long index);
+        SmallScopeValueGenerator(Env* _env, const std::unordered_map<std::string, CommandDef*>& _cons_map,
+                                 const std::shared_ptr<EnumerationState>& _state = nullptr);
+        virtual DataList getRandomDataList(const syntax::TyList& type_list);
+        virtual IncreDataGenerator* fork(Env* _env) const;
+        virtual std::string getSettingDescription() const;
+        virtual std::vector<std::pair<std::string, long long>> getProgress() const;
+        virtual void restoreProgress(const std::vector<std::pair<std::string, long long>>& progress);
+        virtual ~SmallScopeValueGenerator() = default;
+    };
+
     class IncreExampleCollector;
 
     class IncreExampleCollectionEvaluator: public incre::semantics::IncreLabeledEvaluator {
     protected:
         RegisterEvaluateCase(Rewrite);
+        // Global inputs are not bound in the shared context, and thus they are looked up from the collector.
+        RegisterEvaluateCase(Var);
     public:
         IncreExampleCollector* collector;
         IncreExampleCollectionEvaluator(IncreExampleCollector* _collector);
     };
 
+    // The iterative counterpart of IncreExampleCollectionEvaluator, used when KIsUseIterativeName is set.
+    class IncreIterativeCollectionEvaluator: public incre::semantics::IncreIterativeLabeledEvaluator {
+    protected:
+        virtual Data finishRewrite(syntax::TmRewrite* term, const IncreContext& ctx, const Data& res);
+        RegisterEvaluateCase(Var);
+    public:
+        IncreExampleCollector* collector;
+        IncreIterativeCollectionEvaluator(IncreExampleCollector* _collector);
+    };
+
+    /**
+     * The global context is evaluated once and shared read-only by all collectors, where global inputs are left
+     * unbound. The values of global inputs in the current run are stored in current_global, which is private to
+     * the collector.
+     */
     class IncreExampleCollector {
     public:
         std::vector<IncreExampleList> example_pool;
@@ -69,13 +224,25 @@ namespace incre::example {
         std::vector<std::string> global_name;
         DataList current_global;
         IncreFullContext ctx;
-        IncreExampleCollectionEvaluator* eval;
-        std::unordered_map<std::string, EnvAddress*> global_address_map;
+        // An IncreIterativeCollectionEvaluator if is_iterative is set, and an IncreExampleCollectionEvaluator otherwise.
+        incre::semantics::IncreEvaluator* eval;
+        // When set, values created in each collect() are allocated from this arena.
+        PValueArena arena;
 
-        IncreExampleCollector(IncreProgramData* program, const std::vector<std::vector<std::string>>& cared_vars,
-                              const std::vector<std::string>& _global_name);
+        IncreExampleCollector(const IncreFullContext& _ctx, const std::vector<std::vector<std::string>>& cared_vars,
+                              const std::vector<std::string>& _global_name, bool is_iterative = false);
+        // Get the value of a global input in the current run, or a null Data if name is not a global input.
+        Data getGlobalInput(const std::string& name) const;
+        // Get the value of a variable unbound in ctx, which must be a global input.
+        Data getUnboundVar(syntax::TmVar* term) const;
         void add(int rewrite_id, const DataList& local_inp, const Data& oup);
+        // Record an example for a rewrite whose body evaluates to oup under ctx.
+        void addRewrite(syntax::TmRewrite* term, const IncreContext& ctx, const Data& oup);
         virtual void collect(const syntax::Term& start, const DataList& global);
+        void enableArena();
+        // Copy the arena-allocated parts of an example to the heap, such that the arena can be reused. Return false if
+        // the example still refers to the arena, after which this collector no longer uses an arena.
+        bool promote(IncreExampleData* example) const;
         void clear();
         virtual ~IncreExampleCollector();
     };
@@ -83,13 +250,36 @@ namespace incre::example {
     class IncreExamplePool {
     private:
         IncreProgram program;
+        // The evaluated global context shared by all collectors.
+        IncreFullContext global_ctx;
         std::vector<std::vector<std::string>> cared_vars;
         IncreDataGenerator* generator;
         std::vector<bool> is_finished;
         int thread_num;
 
         std::vector<std::pair<std::string, syntax::TyList>> start_list;
-        std::vector<std::unordered_set<std::string>> existing_example_set;
+        std::vector<IncreExampleDedupSet*> existing_example_set;
+        // Guard the appending to example_pool, while the deduplication is done by existing_example_set.
+        std::mutex pool_lock;
+        bool is_use_iterative;
+        // Cleared once an example cannot be fully promoted, such that pools whose examples contain closures do not
+        // keep an arena alive for each of these examples.
+        std::atomic<bool> is_use_arena;
+        // The bodies of pure global functions memoized by each collector, which is empty if memoization is disabled.
+        syntax::TermList memo_body_list;
+        int memo_capacity = 0;
+        // Each worker of generateBatchedExample generates start terms by its own generator and random engine.
+        std::vector<std::shared_ptr<Env>> worker_env_list;
+        std::vector<IncreDataGenerator*> worker_generator_list;
+        // The keys of the examples loaded from the cache for each rewrite, which are read-only after loadCache.
+        std::vector<std::unordered_set<IncreExampleKey, IncreExampleKeyHash>> cached_key_set;
+        // The number of runs whose examples are in the loaded cache, from which the random seed of this run is derived.
+        int cached_run_num = 0;
+        // Whether the examples recorded by collector for rewrite_id from index start are all loaded from the cache.
+        bool isCachedOnly(int rewrite_id, IncreExampleCollector* collector, int start) const;
+        IncreExampleCollector* buildCollector() const;
+        void initWorkers();
+        std::pair<syntax::Term, DataList> generateStart(IncreDataGenerator* gen);
     public:
         std::vector<std::string> global_name_list;
         syntax::TyList global_type_list;
@@ -98,9 +288,28 @@ namespace incre::example {
         std::pair<syntax::Term, DataList> generateStart();
         IncreExamplePool(const IncreProgram& _program, const std::vector<std::vector<std::string>>& _cared_vars, IncreDataGenerator* _g);
         ~IncreExamplePool();
-        void merge(int rewrite_id, IncreExampleCollector* collector, TimeGuard* guard);
+        // Move the new examples in collector to the pool and return the number of those for rewrite_id, which can be
+        // invoked by several threads.
+        int merge(int rewrite_id, IncreExampleCollector* collector, TimeGuard* guard);
+        // Record the memory used by the deduplication of each rewrite into global::recorder.
+        void recordMemoryCost();
         void generateSingleExample();
         void generateBatchedExample(int rewrite_id, int target_num, TimeGuard* guard);
+
+        /**
+         * Examples can be cached on disk across runs. The key hashes the program, the cared variables and the
+         * settings of the generator (see IncreDataGenerator::getSettingDescription), so a cache is reused only by a
+         * run that collects examples from the same distribution. The random seed is excluded, and a run loading a
+         * cache instead moves its generation past the cached runs: the progress of the generator is restored, and the
+         * random engine is reseeded by a seed derived from the number of cached runs.
+         */
+        std::string getCacheKey() const;
+        // Read a cache file and add all its examples to the pool, and return false if the file is missing or does not
+        // match. The file is decoded eagerly, since each example is inserted into the deduplication set. It must be
+        // invoked before any example is generated.
+        bool loadCache(const std::string& path);
+        // Write the examples to a cache file, and return false if some example cannot be serialized.
+        bool saveCache(const std::string& path) const;
     };
 }
 
@@ -7,7 +7,8 @@
 
 #include "istool/incre/language/incre_syntax.h"
 #include "istool/incre/language/incre_types.h"
-#include "istool/incre/language/incre_semantics.h"
+#include "istool/incre/language/incre_compiled_semantics.h"
+#include "istool/incre/language/incre_iterative_semantics.h"
 #include "istool/incre/language/incre_rewriter.h"
 
 namespace incre::syntax {
@@ -58,9 +59,20 @@ namespace incre::semantics {
         virtual ~VLabeledCompress() = default;
     };
 
-    class IncreLabeledEvaluator: public DefaultEvaluator {
+    class IncreLabeledEvaluator: public IncreCompiledEvaluator {
     protected:
         RegisterEvaluateCase(Label);
+    public:
+        // TmLabel is always hooked, and hooked_types lists the other term types hooked by subclasses.
+        IncreLabeledEvaluator(const std::vector<syntax::TermType>& hooked_types = {});
+    };
+
+    // The iterative counterpart of IncreLabeledEvaluator, which evaluates labels without growing the native stack.
+    class IncreIterativeLabeledEvaluator: public IncreIterativeEvaluator {
+    protected:
+        virtual Data buildCompress(syntax::TmLabel* term, const Data& body);
+    public:
+        IncreIterativeLabeledEvaluator(const std::vector<syntax::TermType>& hooked_types = {});
     };
 }
 
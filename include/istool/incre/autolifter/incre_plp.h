@@ -6,6 +6,7 @@
 #define ISTOOL_INCRE_PLP_H
 
 #include "istool/basic/grammar.h"
+#include "istool/basic/compiled_program.h"
 #include "istool/basic/example_space.h"
 #include "istool/incre/analysis/incre_instru_runtime.h"
 #include "istool/incre/analysis/incre_instru_info.h"
@@ -21,9 +22,11 @@ namespace incre::autolifter {
         void addExample();
         Data runExtract(int example_id, Program* prog);
         Data runAux(int example_id, const Data& content, Program* prog);
+        Data runExtract(int example_id, CompiledProgram* prog);
+        Data runAux(int example_id, const Data& content, CompiledProgram* prog);
 
         // cache
-        std::unordered_map<std::string, DataList*> aux_cache, oup_cache;
+        std::unordered_map<uint64_t, DataList*> aux_cache, oup_cache;
     public:
         // cache util
         void extendAuxCache(const AuxProgram& program, DataList* cache_item, int length);
@@ -87,6 +90,8 @@ namespace incre::autolifter {
     Data eliminateCompress(const Data& data);
     Data openLabeledCompress(const Data& data, int label);
     std::string aux2String(const AuxProgram& program);
+    // The key of an aux program in caches, which distinguishes the same programs as aux2String.
+    uint64_t aux2Fingerprint(const AuxProgram& program);
 }
 
 #endif //ISTOOL_INCRE_PLP_H
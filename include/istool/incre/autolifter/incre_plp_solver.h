@@ -61,6 +61,7 @@ namespace incre::autolifter {
         // Used to verify
         int verify_num = 0, verify_pos = 0;
         int KVerifyBaseNum, KExampleTimeOut, KExampleEnlargeFactor;
+        int KEvaluationFuel; // The evaluation budget of an auxiliary program on an example in init and verify.
         std::pair<int, int> verify(const std::vector<AuxProgram>& aux_list);
 
         // Used for synthesis
@@ -82,6 +83,7 @@ namespace incre::autolifter {
 
     extern const std::string KIsMergeVarName;
     extern const std::string KIsIncludeDirectValueName;
+    extern const std::string KEvaluationFuelName;
 }
 
 #endif //ISTOOL_INCRE_PLP_SOLVER_H
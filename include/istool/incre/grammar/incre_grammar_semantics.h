@@ -6,31 +6,58 @@
 #define ISTOOL_INCRE_GRAMMAR_SEMANTICS_H
 
 #include "istool/basic/semantics.h"
-#include "istool/incre/language/incre_semantics.h"
+#include "istool/incre/language/incre_compiled_semantics.h"
+#include "istool/incre/language/incre_iterative_semantics.h"
 
 namespace incre::semantics {
-    class IncreGloablExternalEvaluator: public semantics::DefaultEvaluator {
+    // The global inputs of an operator, whose values are the last global_name->size() parameters.
+    struct IncreGlobalInput {
+        const std::vector<std::string>* global_name;
+        ParamView param;
+        IncreGlobalInput(const std::vector<std::string>* _global_name, const ParamView& _param);
+        // Get the value of a global input, or a null Data if name is not a global input.
+        Data get(const std::string& name) const;
+    };
+
+    class IncreGloablExternalEvaluator: public semantics::IncreCompiledEvaluator {
     protected:
         RegisterEvaluateCase(Var);
-        std::unordered_map<std::string, Data> global_input;
+        const IncreGlobalInput* input;
     public:
-        IncreGloablExternalEvaluator(const std::unordered_map<std::string, Data>& _global_input);
+        IncreGloablExternalEvaluator(const IncreGlobalInput* _input);
         virtual ~IncreGloablExternalEvaluator() = default;
     };
 
+    // The iterative counterpart of IncreGloablExternalEvaluator, used when KIsUseIterativeName is set.
+    class IncreIterativeGlobalExternalEvaluator: public semantics::IncreIterativeEvaluator {
+    protected:
+        RegisterEvaluateCase(Var);
+        const IncreGlobalInput* input;
+    public:
+        IncreIterativeGlobalExternalEvaluator(const IncreGlobalInput* _input);
+        virtual ~IncreIterativeGlobalExternalEvaluator() = default;
+    };
+
     class IncreExecutionInfo: public ExecuteInfo {
     public:
-        IncreGloablExternalEvaluator* eval;
-        IncreExecutionInfo(const DataList& param_list, const std::unordered_map<std::string, Data>& global_input);
+        IncreGlobalInput input;
+        IncreEvaluator* eval;
+        IncreExecutionInfo(const ParamView& param_list, const std::vector<std::string>* global_name, bool is_iterative = false);
+        // Update the parameters and the global inputs, where memoized results are dropped if the global inputs change.
+        void setInput(const ParamView& param_list, const std::vector<std::string>* global_name);
         virtual ~IncreExecutionInfo();
     };
 
     class IncreExecutionInfoBuilder: public ExecuteInfoBuilder {
     public:
         std::vector<std::string> global_name;
-        bool is_enable;
-        IncreExecutionInfoBuilder(const std::vector<std::string>& _global_name);
-        virtual ExecuteInfo* buildInfo(const DataList& _param_value, const FunctionContext& ctx);
+        bool is_enable, is_iterative;
+        // The bodies of pure global functions memoized by each execution info, which is empty if memoization is disabled.
+        syntax::TermList memo_body_list;
+        int memo_capacity;
+        IncreExecutionInfoBuilder(const std::vector<std::string>& _global_name, bool _is_iterative = false);
+        virtual ExecuteInfo* buildInfo(const ParamView& _param_value, const FunctionContext& ctx);
+        virtual void resetInfo(ExecuteInfo* info, const ParamView& _param_value, const FunctionContext& ctx);
     };
 
     class IncreOperatorSemantics: public FullExecutedSemantics {
@@ -49,8 +76,11 @@ namespace incre::semantics {
     };
 
     Data invokeApp(const Data& func, const DataList& param_list, IncreExecutionInfo* info);
+    // Operators are run by iterative evaluators if KIsUseIterativeName is set in env.
     void registerIncreExecutionInfo(Env* env, const std::vector<std::string>& global_names);
     void isConsiderGlobalInputs(Env* env, bool new_flag);
+    // Memoize the pure global functions of program in operators, if KIsUseMemoName is set in env.
+    void enableIncreOperatorMemo(Env* env, IncreProgramData* program);
 }
 
 #endif //ISTOOL_INCRE_GRAMMAR_SEMANTICS_H
@@ -0,0 +1,76 @@
+//
+// Created by pro on 2024/3/12.
+//
+
+#ifndef ISTOOL_INCRE_COMPILED_SEMANTICS_H
+#define ISTOOL_INCRE_COMPILED_SEMANTICS_H
+
+#include "incre_semantics.h"
+#include "incre_program.h"
+
+namespace incre::semantics {
+    class IncreCompiledEvaluator;
+
+    // A term compiled into a tree of specialized nodes, where variables, constructors and operators are resolved.
+    class CompiledTermData {
+    public:
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) = 0;
+        virtual ~CompiledTermData() = default;
+    };
+    typedef std::shared_ptr<CompiledTermData> CompiledTerm;
+
+    // A closure created by compiled code, which carries the compiled body.
+    class VCompiledClosure: public VClosure {
+    public:
+        CompiledTerm compiled_body;
+        int hook_mask; // The hooks the body is compiled with.
+        VCompiledClosure(const IncreContext& _context, const std::string& _name, const syntax::Term& _body,
+                         const syntax::VarScope* _scope, const CompiledTerm& _compiled_body, int _hook_mask);
+        virtual ~VCompiledClosure() = default;
+    };
+
+    /**
+     * An evaluator that compiles terms before running them. preProcess and postProcess are not invoked, and
+     * _evaluate is invoked only for the term types in hooked_types, whose sub-terms are still run in the compiled form
+     * when the hook evaluates them via evaluate. Besides, _evaluate(TmVar*) is invoked for variables that are not
+     * resolved or whose global bindings have no value.
+     * Compiled bodies of closures created by other evaluators are cached, so an evaluator must not be shared by threads.
+     */
+    class IncreCompiledEvaluator: public DefaultEvaluator {
+    private:
+        int hook_mask;
+        std::unordered_map<syntax::TermData*, std::pair<syntax::Term, CompiledTerm>> body_cache;
+        // Compiled terms passed to evaluate, where a released term is recompiled if its address is reused.
+        std::unordered_map<syntax::TermData*, std::pair<std::weak_ptr<syntax::TermData>, CompiledTerm>> term_cache;
+        size_t term_cache_limit = 64;
+        CompiledTerm getCompiled(syntax::TermData* term);
+        std::vector<std::pair<syntax::TermData*, CompiledTermData*>> hook_children;
+        CompiledTermData* getBody(VClosure* closure);
+    protected:
+        virtual Data runClosure(VClosure* closure, const Data& param);
+    public:
+        IncreCompiledEvaluator(const std::vector<syntax::TermType>& hooked_types = {});
+        // Compile a term using the resolution by resolveTerm, where the term is never modified.
+        CompiledTerm compile(syntax::TermData* term);
+        virtual Data evaluate(syntax::TermData* term, const IncreContext& ctx);
+        Data apply(const Data& func, const Data& param);
+        // Invoke _evaluate on a hooked term, where its sub-terms are run in the compiled form.
+        Data runHook(syntax::TermData* term, const std::vector<std::pair<syntax::TermData*, CompiledTerm>>& sub_list, const IncreContext& ctx);
+        // Evaluate a term by the interpreter, where _evaluate is invoked.
+        Data interpret(syntax::TermData* term, const IncreContext& ctx);
+        int getHookMask() const;
+        virtual ~IncreCompiledEvaluator() = default;
+    };
+
+    // Whether applications of pure global functions are memoized when collecting examples and running operators.
+    extern const std::string KIsUseMemoName;
+    extern const std::string KMemoCapacityName;
+    /**
+     * Get the bodies of global functions that are pure, i.e., they reach no rewrite directly or via other globals.
+     * The analysis is syntactic and over-approximates the references, where a local variable sharing the name of an
+     * impure global makes the function impure as well.
+     */
+    syntax::TermList collectPureFunctionBodies(IncreProgramData* program);
+}
+
+#endif //ISTOOL_INCRE_COMPILED_SEMANTICS_H
@@ -14,21 +14,48 @@ namespace incre {
         std::string name;
         syntax::Binding bind;
         std::shared_ptr<EnvAddress> next;
+        int index; // The position counted from the outermost binding.
         EnvAddress(const std::string &_name, const syntax::Binding& _bind, const std::shared_ptr<EnvAddress>& _next);
     };
 
+    // An array-backed frame storing the values bound by a single binder during evaluation.
+    class IncreFrame {
+    public:
+        std::shared_ptr<IncreFrame> parent;
+        const syntax::VarScope* scope;
+        DataList slot_list;
+        IncreFrame(const std::shared_ptr<IncreFrame>& _parent, const syntax::VarScope* _scope);
+    };
+    typedef std::shared_ptr<IncreFrame> PIncreFrame;
+
+    /**
+     * The linked bindings from start are used by the type checker and store global values. During evaluation,
+     * local values are stored in frame, and global_list indexes the bindings from start by EnvAddress::index.
+     * insert indexes the new binding in a copy of global_list, such that a shared context can be extended concurrently.
+     */
     class IncreContext {
     public:
         std::shared_ptr<EnvAddress> start;
+        PIncreFrame frame;
+        std::shared_ptr<std::vector<EnvAddress*>> global_list;
         syntax::Ty getRawType(const std::string& _name) const;
         syntax::Ty getFinalType(const std::string& _name, syntax::IncreTypeRewriter* rewriter) const;
         Data getData(const std::string& _name) const;
+        // Get the value of a variable, using its resolution if any. A null Data is returned when the global binding
+        // has no value.
+        Data getData(syntax::TmVar* var) const;
+        // Get the global binding with the given index, or nullptr if it is not indexed in this context.
+        EnvAddress* getGlobal(int index) const;
         bool isContain(const std::string& name);
         EnvAddress* getAddress(const std::string& name);
         void printTypes() const;
         void printDatas() const;
         IncreContext insert(const std::string& name, const syntax::Binding& binding) const;
+        IncreContext pushFrame(const syntax::VarScope* scope) const;
+        IncreContext indexGlobals() const;
         IncreContext(const std::shared_ptr<EnvAddress>& _start);
+        IncreContext(const std::shared_ptr<EnvAddress>& _start, const PIncreFrame& _frame,
+                     const std::shared_ptr<std::vector<EnvAddress*>>& _global_list);
     };
 
     class IncreFullContextData {
@@ -40,6 +67,9 @@ namespace incre {
         void setGlobalInput(const std::unordered_map<std::string, Data>& global_input);
     };
     typedef std::shared_ptr<IncreFullContextData> IncreFullContext;
+
+    // Scopes are interned, so that they can be compared by addresses and never outlive the frames using them.
+    const syntax::VarScope* internScope(const syntax::VarScope& scope);
 }
 
 #endif //ISTOOL_CONTEXT_H
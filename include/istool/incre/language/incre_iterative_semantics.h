@@ -0,0 +1,53 @@
+//
+// Created by pro on 2024/3/14.
+//
+
+#ifndef ISTOOL_INCRE_ITERATIVE_SEMANTICS_H
+#define ISTOOL_INCRE_ITERATIVE_SEMANTICS_H
+
+#include "incre_semantics.h"
+
+namespace incre::semantics {
+    /**
+     * An evaluator that keeps the pending computations in explicit stacks instead of the native stack, such that the
+     * native stack depth does not grow with the size of the evaluated data. Applications in tail positions (the
+     * branches of if, the bodies of let and match cases, and the bodies of functions) leave nothing on the stacks,
+     * unless their results are memoized. preProcess and postProcess are not invoked, and _evaluate is invoked only
+     * for the term types in hooked_types, whose sub-terms are evaluated by a nested run of the machine. Besides,
+     * _evaluate(TmVar*) is invoked for variables that have no value in the context. Labels and rewrites are
+     * customized by buildCompress and finishRewrite instead, which keep the stacks flat.
+     * Terms are referred to by raw pointers during evaluation, so they must outlive the evaluation.
+     */
+    class IncreIterativeEvaluator: public DefaultEvaluator {
+    public:
+        enum class ContinuationType {
+            IF, APP_PARAM, APP_CALL, LET, MATCH, TUPLE, PRIMARY, PROJ, CONS, LABEL, UNLABEL, REWRITE, MEMO
+        };
+        struct Continuation {
+            ContinuationType type;
+            syntax::TermData* term;
+            IncreContext ctx;
+            // The number of evaluated operands for TUPLE and PRIMARY, and the index of the memo entry for MEMO.
+            int index;
+        };
+    private:
+        int hook_mask;
+        std::vector<Continuation> continuation_stack;
+        DataList value_stack;
+        Data runHook(syntax::TermData* term, const IncreContext& ctx);
+    protected:
+        // Build the value of term from the value of its body.
+        virtual Data buildCompress(syntax::TmLabel* term, const Data& body);
+        // Invoked when the body of term evaluates to res under ctx, which returns the value of term.
+        virtual Data finishRewrite(syntax::TmRewrite* term, const IncreContext& ctx, const Data& res);
+    public:
+        IncreIterativeEvaluator(const std::vector<syntax::TermType>& hooked_types = {});
+        virtual Data evaluate(syntax::TermData* term, const IncreContext& ctx);
+        virtual ~IncreIterativeEvaluator() = default;
+    };
+
+    // Whether examples are collected and operators are run by iterative evaluators, for programs on deep data.
+    extern const std::string KIsUseIterativeName;
+}
+
+#endif //ISTOOL_INCRE_ITERATIVE_SEMANTICS_H
@@ -8,6 +8,7 @@
 #include "incre_context.h"
 #include "istool/sygus/theory/basic/clia/clia.h"
 #include "istool/ext/deepcoder/data_value.h"
+#include <atomic>
 
 namespace incre::semantics {
 
@@ -21,19 +22,16 @@ namespace incre::semantics {
 
     typedef IntValue VInt;
     typedef BoolValue VBool;
+    typedef UnitValue VUnit;
     typedef ProductValue VTuple;
 
-    class VUnit: public Value {
-    public:
-        virtual std::string toString() const;
-        virtual bool equal(Value* value) const;
-    };
-
     class VClosure: public Value {
     public:
         IncreContext context;
         std::string name; syntax::Term body;
+        const syntax::VarScope* scope; // The scope of the frame storing the parameter.
         VClosure(const IncreContext& _context, const std::string& _name, const syntax::Term& _body);
+        VClosure(const IncreContext& _context, const std::string& _name, const syntax::Term& _body, const syntax::VarScope* _scope);
         VClosure(const std::tuple<IncreContext, std::string, syntax::Term>& _content);
         virtual std::string toString() const;
         virtual bool equal(Value* value) const;
@@ -41,12 +39,19 @@ namespace incre::semantics {
 
     class VInd: public Value {
     public:
-        std::string name;
+        int tag; // See syntax::getConsTag.
         Data body;
+        mutable std::atomic<size_t> hash_cache; // 0 if the hash is not computed yet.
+        VInd(int _tag, const Data& _body);
         VInd(const std::string& _name, const Data& _body);
         VInd(const std::pair<std::string, Data>& _content);
+        const std::string& getName() const;
+        // toString, equal, hash and the destructor traverse nested inductive values by explicit stacks, such that
+        // long chains of values (e.g., long lists) do not overflow the native stack.
         virtual std::string toString() const;
         virtual bool equal(Value* value) const;
+        virtual size_t hash() const;
+        virtual ~VInd();
     };
 
     class VCompress: public Value {
@@ -55,17 +60,59 @@ namespace incre::semantics {
         VCompress(const Data& _body);
         virtual std::string toString() const;
         virtual bool equal(Value* value) const;
+        virtual size_t hash() const;
     };
 
 #define RegisterAbstractEvaluateCase(name) virtual Data _evaluate(syntax::Tm ## name* term, const IncreContext& ctx) = 0
+    /**
+     * Applications of functions known to be pure can be memoized by enableMemo. The memo table is bounded and owned by
+     * the evaluator, and thus each thread has its own table.
+     */
     class IncreEvaluator {
+    private:
+        struct MemoEntry {
+            syntax::TermData* func = nullptr;
+            Data param, result;
+        };
+        std::unordered_map<syntax::TermData*, syntax::Term> memo_functions;
+        int memo_capacity = 0;
+        // The table is allocated on the first memoized application, and memo_used records the occupied entries.
+        std::vector<MemoEntry> memo_table;
+        std::vector<int> memo_used;
     protected:
         TERM_CASE_ANALYSIS(RegisterAbstractEvaluateCase);
         virtual void preProcess(syntax::TermData* term, const IncreContext& ctx) = 0;
         virtual void postProcess(syntax::TermData* term, const IncreContext& ctx, const Data& res) = 0;
+        // Apply closure to a single parameter, which consumes fuel and is answered by the memo table if possible.
+        Data applyOne(VClosure* closure, const Data& param);
+        // Evaluate the body of closure, where param is bound directly into the frame of the body.
+        virtual Data runClosure(VClosure* closure, const Data& param);
+        // The index of the memo entry for applying closure to param, or -1 if the application is not memoized.
+        int getMemoIndex(VClosure* closure, const Data& param);
+        // Whether the entry at index stores the result of applying the function with body to param, written to res.
+        bool lookupMemo(int index, syntax::TermData* body, const Data& param, Data& res) const;
+        void storeMemo(int index, syntax::TermData* body, const Data& param, const Data& res);
     public:
+        // The number of function applications the evaluator can still perform, or a negative number for no limit. It
+        // is set by the caller before an evaluation call, and an IncreSemanticsError is thrown when it runs out.
+        int fuel = -1;
+        void consumeFuel();
         virtual ~IncreEvaluator() = default;
-        Data evaluate(syntax::TermData* term, const IncreContext& ctx);
+        // Global variables are looked up by names if ctx is not indexed, so contexts should be indexed once when built.
+        virtual Data evaluate(syntax::TermData* term, const IncreContext& ctx);
+        // Apply closure to params one by one, where each parameter is bound directly without building any term.
+        Data applyClosure(VClosure* closure, const DataList& params);
+        /**
+         * Memoize applications of the closures whose bodies are in pure_bodies, keyed by the body and the parameter.
+         * Only top-level closures, whose results depend only on the parameter and the global bindings, are memoized,
+         * and applications to closures are never memoized since the parameter may have side effects. The functions
+         * must be pure, i.e., invoke no hook with side effects. The table keeps at most capacity entries, where
+         * an entry is replaced by a later application hashed to the same slot. Parameters interned in a
+         * DataHashConsTable are compared in O(1) time.
+         */
+        void enableMemo(const syntax::TermList& pure_bodies, int capacity);
+        // Drop all memoized results, which must be invoked when the global bindings change.
+        void clearMemo();
     };
 
 #define RegisterEvaluateCase(name) virtual Data _evaluate(syntax::Tm ## name* term, const IncreContext& ctx)
@@ -80,8 +127,21 @@ namespace incre::semantics {
 
     typedef std::function<IncreEvaluator*()> IncreEvaluatorGenerator;
 
+    /**
+     * Resolve the variables in term to frame slots and global indices, assuming term is evaluated under ctx, and
+     * attach the scopes of frames to binders. This is the only place where terms are modified, and thus it must be
+     * invoked before term is shared by threads. Evaluation only reads the resolution.
+     */
+    void resolveTerm(syntax::TermData* term, const IncreContext& ctx);
+    // The scopes of the frames introduced by functions, lets and match cases. They are cached on terms by resolveTerm,
+    // and thus terms evaluated repeatedly should be resolved first: otherwise the scope is interned on each call.
+    const syntax::VarScope* getFrameScope(syntax::TmFunc* term);
+    const syntax::VarScope* getFrameScope(syntax::TmLet* term);
+    const syntax::VarScope* getFrameScope(syntax::TmMatch* term, int case_id);
     bool isValueMatchPattern(syntax::PatternData* pattern, const Data& data);
     IncreContext bindValueWithPattern(syntax::PatternData* pattern, const Data& data, const IncreContext& ctx);
+    // Write the values bound by a matched pattern into consecutive slots from pos, in the order of getVarsInPattern.
+    void bindValueToSlots(syntax::PatternData* pattern, const Data& data, Data*& pos);
     Data invokePrimary(const std::string& name, const DataList& params);
 
 }
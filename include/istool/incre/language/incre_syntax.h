@@ -35,6 +35,7 @@ namespace incre::syntax {
     class TyVar: public TypeData {
     public:
         TypeVarInfo info;
+        int rank; // The rank of the variable in union-find, see DefaultIncreTypeChecker::_unify.
         TyVar(const TypeVarInfo& _info);
         std::tuple<int, int, VarRange> get_var_info() const;
         void intersectWith(const VarRange& range);
@@ -146,9 +147,14 @@ namespace incre::syntax {
         virtual std::string toString() const;
     };
 
+    // Constructors are identified by dense integer tags, which are assigned in the order of registration.
+    int getConsTag(const std::string& name);
+    const std::string& getConsName(int tag);
+
     class PtCons: public PatternData {
     public:
         std::string name;
+        int tag;
         Pattern body;
         PtCons(const std::string& _name, const Pattern& _body);
         virtual std::string toString() const;
@@ -164,7 +170,11 @@ namespace incre::syntax {
 
     std::string termType2String(TermType type);
 
-    class TermData {
+    // The names bound by a single binder (a function, a let, or a match case), in slot order.
+    typedef std::vector<std::string> VarScope;
+
+    // Terms are owned by shared pointers, through which evaluators can tell whether a cached term is still alive.
+    class TermData: public std::enable_shared_from_this<TermData> {
     public:
         TermType term_type;
         TermType getType() const;
@@ -192,6 +202,10 @@ namespace incre::syntax {
     class TmVar: public TermData {
     public:
         std::string name;
+        // Filled by semantics::resolveTerm. A non-negative depth refers to slot of the depth-th enclosing frame,
+        // whose scope must be the same as scope; depth = -1 refers to the global binding with index slot.
+        int depth = -1, slot = -1;
+        const VarScope* scope = nullptr;
         TmVar(const std::string& _name);
         virtual std::string toString() const;
     };
@@ -215,6 +229,7 @@ namespace incre::syntax {
     public:
         std::string name;
         Term body;
+        const VarScope* scope = nullptr;
         TmFunc(const std::string & _name, const Term& _body);
         virtual std::string toString() const;
     };
@@ -224,6 +239,7 @@ namespace incre::syntax {
         std::string name;
         bool is_rec;
         Term def, body;
+        const VarScope* scope = nullptr;
         TmLet(const std::string& _name, bool _is_rec, const Term& _def, const Term& _body);
         virtual std::string toString() const;
     };
@@ -249,6 +265,7 @@ namespace incre::syntax {
     public:
         Term def;
         MatchCaseList cases;
+        std::vector<const VarScope*> scope_list;
         TmMatch(const Term& _def, const MatchCaseList& _cases);
         virtual std::string toString() const;
     };
@@ -256,6 +273,7 @@ namespace incre::syntax {
     class TmCons: public TermData {
     public:
         std::string cons_name;
+        int cons_tag;
         Term body;
         TmCons(const std::string& _cons_name, const Term& body);
         virtual std::string toString() const;
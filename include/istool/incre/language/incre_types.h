@@ -20,6 +20,9 @@ namespace incre::types {
     syntax::Ty getSyntaxValueType(const Data& data);
     syntax::Ty getPrimaryType(const std::string& name);
     void checkAndUpdate(syntax::VarRange x, syntax::TypeData* type);
+    // Follow the bindings of type variables from type to its representative, which is either an unbound variable or
+    // not a variable. Variables on the path are rebound to the representative directly (path compression).
+    syntax::Ty findRepresentative(const syntax::Ty& type);
 
 #define RegisterAbstractTypingRule(name) virtual syntax::Ty _typing(syntax::Tm ## name* term, const IncreContext& ctx) = 0;
 #define RegisterAbstractUnifyRule(name) virtual void _unify(syntax::Ty ## name* x, syntax::Ty ## name* y, const syntax::Ty& _x, const syntax::Ty& _y) = 0;
@@ -51,6 +54,8 @@ namespace incre::types {
         virtual void preProcess(syntax::TermData* term, const IncreContext& ctx);
         virtual syntax::Ty postProcess(syntax::TermData* term, const IncreContext& ctx, const syntax::Ty& res);
         virtual void updateLevelBeforeUnification(syntax::TypeData* x, int index, int level);
+        // Bind unbound variable x to _y, where y is the variable in _y if _y is an unbound variable.
+        void bindVar(syntax::TyVar* x, syntax::TyVar* y, const syntax::Ty& _x, const syntax::Ty& _y);
         virtual std::pair<syntax::Ty, IncreContext> processPattern(syntax::PatternData* pattern, const IncreContext& ctx);
         virtual syntax::Ty normalize(const syntax::Ty& type);
     public:
@@ -17,7 +17,7 @@ public:
 
 class LiftingCache {
 public:
-    std::unordered_map<std::string, int> program_map;
+    std::unordered_map<uint64_t, int> program_map;
     std::vector<DataList*> cache;
     DataList* registerProgram(Program* program, const DataList& res);
     DataList* getCache(Program* program);
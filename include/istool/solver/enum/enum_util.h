@@ -6,6 +6,7 @@
 #define ISTOOL_ENUM_UTIL_H
 
 #include "enum.h"
+#include "istool/basic/program_store.h"
 #include <unordered_set>
 
 class TrivialOptimizer: public Optimizer {
@@ -28,10 +29,13 @@ public:
 };
 
 class OBEOptimizer: public Optimizer {
+    ProgramEvalCache* getCache(const std::string& name);
 public:
     ProgramChecker* is_runnable;
     std::unordered_map<std::string, ExampleList> example_pool;
-    std::unordered_set<std::string> visited_set;
+    std::unordered_map<int, std::unordered_set<DataList, data::DataListHash>> visited_set;
+    // The results of the accepted programs, such that a candidate is evaluated only on its root.
+    std::unordered_map<std::string, ProgramEvalCache*> cache_pool;
     Env* env;
     OBEOptimizer(ProgramChecker* _is_runnable, const std::unordered_map<std::string, ExampleList>& _pool, Env* _env);
     virtual bool isDuplicated(const std::string& name, NonTerminal* nt, const PProgram& p);
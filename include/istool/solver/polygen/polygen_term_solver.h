@@ -48,7 +48,7 @@ namespace polygen {
     };
 
     struct TermSolverCache {
-        std::unordered_map<std::string, AssignmentInfo*> info_map;
+        std::unordered_map<uint64_t, AssignmentInfo*> info_map;
         std::map<std::vector<int>, polygen::AssignmentInfo*> solved_sample;
         std::set<polygen::TermPlan*, polygen::TermPlanCmp> plan_set;
         TermPlan* buildTermPlan(int n, const std::vector<AssignmentInfo*>& term_list);
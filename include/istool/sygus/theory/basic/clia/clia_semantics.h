@@ -13,6 +13,7 @@ public:
     Data* inf;
     IntPlusSemantics(Data* _inf);
     virtual Data run(DataList &&inp_list, ExecuteInfo *info);
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~IntPlusSemantics() = default;
 };
 
@@ -21,6 +22,7 @@ public:
     Data* inf;
     IntMinusSemantics(Data* _inf);
     virtual Data run(DataList &&inp_list, ExecuteInfo *info);
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~IntMinusSemantics() = default;
 };
 
@@ -29,15 +31,16 @@ public:
     Data* inf;
     IntTimesSemantics(Data* _inf);
     virtual Data run(DataList &&inp_list, ExecuteInfo *info);
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~IntTimesSemantics() = default;
 };
 
 DefineNormalSemantics(IntDiv)
 DefineNormalSemantics(IntMod)
-DefineNormalSemantics(Lq)
-DefineNormalSemantics(Gq)
-DefineNormalSemantics(Leq)
-DefineNormalSemantics(Geq)
+DefineBatchedNormalSemantics(Lq)
+DefineBatchedNormalSemantics(Gq)
+DefineBatchedNormalSemantics(Leq)
+DefineBatchedNormalSemantics(Geq)
 DefineNormalSemantics(Eq)
 DefineNormalSemantics(EqBool)
 DefineNormalSemantics(Neq)
@@ -47,6 +50,8 @@ public:
     IteSemantics();
     virtual Data run(DataList &&inp_list, ExecuteInfo *info);
     virtual Data run(const ProgramList &sub_list, ExecuteInfo *info);
+    virtual bool isLazy() const;
+    virtual DataList runBatch(std::vector<DataList>&& inp_list, const std::vector<ExecuteInfo*>& info_list);
     ~IteSemantics() = default;
 };
 
@@ -9,16 +9,6 @@
 #include "istool/basic/value.h"
 #include "istool/basic/type_system.h"
 
-class IntValue: public Value, public ComparableValue {
-public:
-    int w;
-    IntValue(int _w);
-    virtual std::string toString() const;
-    virtual std::string toHaskell(bool in_result) const;
-    virtual bool equal(Value* value) const;
-    virtual bool leq(Value* value) const;
-};
-
 class IntValueTypeInfo: public ValueTypeInfo {
     PType int_type;
 public:
@@ -6,7 +6,7 @@
 #include "istool/incre/analysis/incre_instru_types.h"
 #include "istool/basic/config.h"
 #include "glog/logging.h"
-#include <queue>
+#include <atomic>
 #include <thread>
 #include <mutex>
 
@@ -16,27 +16,65 @@ using namespace incre::semantics;
 using namespace incre::example;
 
 incre::example::IncreExampleCollectionEvaluator::IncreExampleCollectionEvaluator(IncreExampleCollector *_collector):
-    collector(_collector) {
+    IncreLabeledEvaluator({TermType::REWRITE}), collector(_collector) {
 }
 
 Data IncreExampleCollectionEvaluator::_evaluate(syntax::TmRewrite *term, const IncreContext &ctx) {
-    auto* labeled_term = dynamic_cast<TmLabeledRewrite*>(term);
-    if (!labeled_term) LOG(INFO) << "Expected TmLabeledRewrite, but got " << term->toString();
-    auto oup = evaluate(labeled_term->body.get(), ctx);
-    DataList local_inp;
-    for (auto& name: collector->cared_vars[labeled_term->id]) {
-        local_inp.push_back(ctx.getData(name));
-    }
-    collector->add(labeled_term->id, local_inp, oup);
+    auto oup = evaluate(term->body.get(), ctx);
+    collector->addRewrite(term, ctx, oup);
     return oup;
 }
 
-IncreExampleCollector::IncreExampleCollector(IncreProgramData *program,
+Data IncreExampleCollectionEvaluator::_evaluate(syntax::TmVar *term, const IncreContext &ctx) {
+    auto res = ctx.getData(term);
+    if (!res.isNull()) return res;
+    return collector->getUnboundVar(term);
+}
+
+IncreIterativeCollectionEvaluator::IncreIterativeCollectionEvaluator(IncreExampleCollector *_collector):
+    collector(_collector) {
+}
+
+Data IncreIterativeCollectionEvaluator::finishRewrite(syntax::TmRewrite *term, const IncreContext &ctx, const Data &res) {
+    collector->addRewrite(term, ctx, res);
+    return res;
+}
+
+Data IncreIterativeCollectionEvaluator::_evaluate(syntax::TmVar *term, const IncreContext &ctx) {
+    // The machine invokes this only for variables without values in ctx.
+    return collector->getUnboundVar(term);
+}
+
+IncreExampleCollector::IncreExampleCollector(const IncreFullContext &_ctx,
                                              const std::vector<std::vector<std::string>> &_cared_vars,
-                                             const std::vector<std::string> &_global_name):
-                                             cared_vars(_cared_vars), global_name(_global_name), example_pool(_cared_vars.size()) {
-    eval = new IncreExampleCollectionEvaluator(this);
-    ctx = buildContext(program, eval, nullptr);
+                                             const std::vector<std::string> &_global_name, bool is_iterative):
+                                             cared_vars(_cared_vars), global_name(_global_name), example_pool(_cared_vars.size()), ctx(_ctx) {
+    if (is_iterative) eval = new IncreIterativeCollectionEvaluator(this);
+    else eval = new IncreExampleCollectionEvaluator(this);
+}
+
+Data IncreExampleCollector::getGlobalInput(const std::string &name) const {
+    for (int i = 0; i < current_global.size(); ++i) {
+        if (global_name[i] == name) return current_global[i];
+    }
+    return {};
+}
+
+Data IncreExampleCollector::getUnboundVar(syntax::TmVar *term) const {
+    auto res = getGlobalInput(term->name);
+    if (res.isNull()) LOG(FATAL) << "No data is bound to " << term->name;
+    return res;
+}
+
+void IncreExampleCollector::addRewrite(syntax::TmRewrite *term, const IncreContext &ctx, const Data &oup) {
+    auto* labeled_term = dynamic_cast<TmLabeledRewrite*>(term);
+    if (!labeled_term) LOG(INFO) << "Expected TmLabeledRewrite, but got " << term->toString();
+    DataList local_inp;
+    for (auto& name: cared_vars[labeled_term->id]) {
+        auto value = getGlobalInput(name);
+        local_inp.push_back(value.isNull() ? ctx.getData(name) : value);
+    }
+    add(labeled_term->id, local_inp, oup);
 }
 
 void
@@ -46,14 +84,80 @@ IncreExampleCollector::add(int rewrite_id, const DataList &local_inp, const Data
 }
 
 void IncreExampleCollector::collect(const syntax::Term &start, const DataList &global) {
-    std::unordered_map<std::string, Data> global_inp_map;
-    for (int i = 0; i < global.size(); ++i) {
-        global_inp_map[global_name[i]] = global[i];
+    if (global.size() != global_name.size()) {
+        LOG(FATAL) << "Expect " << std::to_string(global_name.size()) << " global inputs, but received " << std::to_string(global.size());
+    }
+    current_global = global;
+    // Memoized results may read the global inputs or be allocated from the arena, both of which change in each run.
+    if (!global_name.empty() || arena) eval->clearMemo();
+    // The arena is kept alive by a recorded example only when that example refers to it (see promote), in which case
+    // the arena cannot be reused and this collector falls back to the heap. Otherwise, all values of the previous run
+    // have been either promoted or released.
+    if (arena && arena.use_count() > 1) arena = nullptr;
+    if (!arena) {
+        eval->evaluate(start.get(), ctx->ctx); return;
     }
-    ctx->setGlobalInput(global_inp_map); current_global = global;
+    arena->reset();
+    ArenaScope scope(arena);
     eval->evaluate(start.get(), ctx->ctx);
 }
 
+void IncreExampleCollector::enableArena() {
+    if (!arena) arena = std::make_shared<ValueArena>();
+}
+
+namespace {
+    // Values are copied in post-order by explicit stacks, such that deep values do not overflow the native stack.
+    Data _promote(const Data& data, ValueArena* arena, bool& is_escaped) {
+        std::vector<std::pair<const Data*, bool>> task_stack = {{&data, false}};
+        DataList result_stack;
+        while (!task_stack.empty()) {
+            auto [now, is_expanded] = task_stack.back(); task_stack.pop_back();
+            if (now->getKind() != DataKind::VALUE || !arena->contains(now->get())) {
+                result_stack.push_back(*now); continue;
+            }
+            auto* vi = dynamic_cast<VInd*>(now->get());
+            auto* vt = dynamic_cast<VTuple*>(now->get());
+            auto* vc = dynamic_cast<VCompress*>(now->get());
+            if (!vi && !vt && !vc) {
+                // Other values (e.g., closures, which refer to whole contexts) are kept in the arena.
+                is_escaped = true; result_stack.push_back(*now); continue;
+            }
+            if (!is_expanded) {
+                task_stack.emplace_back(now, true);
+                if (vi) task_stack.emplace_back(&vi->body, false);
+                else if (vc) task_stack.emplace_back(&vc->body, false);
+                else {
+                    for (int i = int(vt->elements.size()) - 1; i >= 0; --i) task_stack.emplace_back(&vt->elements[i], false);
+                }
+                continue;
+            }
+            if (vt) {
+                DataList elements(std::make_move_iterator(result_stack.end() - vt->elements.size()), std::make_move_iterator(result_stack.end()));
+                result_stack.resize(result_stack.size() - vt->elements.size());
+                result_stack.push_back(Data(std::make_shared<VTuple>(elements)));
+                continue;
+            }
+            auto body = std::move(result_stack.back()); result_stack.pop_back();
+            if (vi) result_stack.push_back(Data(std::make_shared<VInd>(vi->tag, body)));
+            else if (auto* vl = dynamic_cast<VLabeledCompress*>(vc)) {
+                result_stack.push_back(Data(std::make_shared<VLabeledCompress>(body, vl->id)));
+            } else result_stack.push_back(Data(std::make_shared<VCompress>(body)));
+        }
+        return result_stack.back();
+    }
+}
+
+bool IncreExampleCollector::promote(IncreExampleData *example) const {
+    if (!arena) return true;
+    bool is_escaped = false;
+    for (auto& inp: example->local_inputs) inp = _promote(inp, arena.get(), is_escaped);
+    for (auto& inp: example->global_inputs) inp = _promote(inp, arena.get(), is_escaped);
+    example->oup = _promote(example->oup, arena.get(), is_escaped);
+    if (is_escaped) example->arena = arena;
+    return !is_escaped;
+}
+
 IncreExampleCollector::~IncreExampleCollector() {
     delete eval;
 }
@@ -63,36 +167,139 @@ void IncreExampleCollector::clear() {
     for (auto& example_list: example_pool) example_list.clear();
 }
 
-void IncreExamplePool::merge(int main_id, IncreExampleCollector *collector, TimeGuard* guard) {
+namespace {
+    size_t _mix(size_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31u);
+    }
+
+    void _addComponent(IncreExampleKey& key, size_t value) {
+        key.low = data::hashCombine(key.low, value);
+        key.high = _mix(key.high ^ _mix(value));
+    }
+
+    void _addComponentList(IncreExampleKey& key, const DataList& data_list) {
+        _addComponent(key, data_list.size());
+        for (auto& data: data_list) _addComponent(key, data.hash());
+    }
+}
+
+IncreExampleKey::IncreExampleKey(IncreExampleData *example): low(0), high(0) {
+    _addComponent(*this, example->rewrite_id);
+    _addComponentList(*this, example->local_inputs);
+    _addComponentList(*this, example->global_inputs);
+    _addComponent(*this, example->oup.hash());
+}
+
+IncreExampleDedupSet::IncreExampleDedupSet(bool _is_exact, int shard_num): is_exact(_is_exact), shard_list(shard_num) {
+}
+
+IncreExampleDedupSet::Shard &IncreExampleDedupSet::getShard(const IncreExampleKey &key) {
+    // The shard is selected by high, while the buckets in a shard are selected by low.
+    return shard_list[key.high % shard_list.size()];
+}
+
+bool IncreExampleDedupSet::contains(const IncreExampleKey &key, IncreExampleData *example) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto [begin, end] = shard.example_map.equal_range(key);
+    if (!is_exact) return begin != end;
+    for (auto it = begin; it != end; ++it) {
+        if (*(it->second) == *example) return true;
+    }
+    return false;
+}
+
+bool IncreExampleDedupSet::insert(const IncreExampleKey &key, const IncreExample &example) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto [begin, end] = shard.example_map.equal_range(key);
+    if (!is_exact) {
+        if (begin != end) return false;
+        shard.example_map.emplace(key, nullptr);
+        return true;
+    }
+    for (auto it = begin; it != end; ++it) {
+        if (*(it->second) == *example) return false;
+    }
+    shard.example_map.emplace(key, example);
+    return true;
+}
+
+int IncreExampleDedupSet::size() {
+    int res = 0;
+    for (auto& shard: shard_list) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        res += shard.example_map.size();
+    }
+    return res;
+}
+
+size_t IncreExampleDedupSet::getMemoryCost() {
+    // A node stores the next pointer, the cached hash and the entry.
+    const size_t node_size = sizeof(void*) + sizeof(size_t) + sizeof(std::pair<const IncreExampleKey, IncreExample>);
+    size_t res = sizeof(IncreExampleDedupSet) + shard_list.size() * sizeof(Shard);
+    for (auto& shard: shard_list) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        res += shard.example_map.size() * node_size + shard.example_map.bucket_count() * sizeof(void*);
+    }
+    return res;
+}
+
+int IncreExamplePool::merge(int main_id, IncreExampleCollector *collector, TimeGuard* guard) {
     assert(collector->example_pool.size() == example_pool.size());
     std::vector<int> index_order;
     index_order.push_back(main_id);
     for (int i = 0; i < example_pool.size(); ++i) {
         if (i != main_id) index_order.push_back(i);
     }
+    std::vector<IncreExampleList> new_example_pool(example_pool.size());
     for (auto rewrite_id: index_order) {
+        auto* example_set = existing_example_set[rewrite_id];
         for (int example_id = 0; example_id < collector->example_pool[rewrite_id].size(); ++example_id) {
             auto& new_example = collector->example_pool[rewrite_id][example_id];
-            auto feature = new_example->toString();
-            if (existing_example_set[rewrite_id].find(feature) == existing_example_set[rewrite_id].end()) {
-                existing_example_set[rewrite_id].insert(feature);
-                example_pool[rewrite_id].push_back(new_example);
+            IncreExampleKey key(new_example.get());
+            // An example is promoted before being inserted, since the inserted examples can be read by other threads.
+            if (!example_set->contains(key, new_example.get())) {
+                if (!collector->promote(new_example.get())) is_use_arena = false;
+                if (example_set->insert(key, new_example)) new_example_pool[rewrite_id].push_back(new_example);
             }
             if ((example_id & 255) == 255 && guard && guard->getRemainTime() < 0) break;
         }
     }
     collector->clear();
+    std::lock_guard<std::mutex> lock(pool_lock);
+    for (int rewrite_id = 0; rewrite_id < example_pool.size(); ++rewrite_id) {
+        auto& new_list = new_example_pool[rewrite_id];
+        example_pool[rewrite_id].insert(example_pool[rewrite_id].end(), new_list.begin(), new_list.end());
+    }
+    return new_example_pool[main_id].size();
+}
+
+void IncreExamplePool::recordMemoryCost() {
+    for (int rewrite_id = 0; rewrite_id < existing_example_set.size(); ++rewrite_id) {
+        auto cost = existing_example_set[rewrite_id]->getMemoryCost();
+        global::recorder.record("#example-set-kb@" + std::to_string(rewrite_id), int(cost >> 10u));
+    }
 }
 
 std::pair<syntax::Term, DataList> IncreExamplePool::generateStart() {
-    DataList global_inp;
-    for (auto& ty: global_type_list) global_inp.push_back(generator->getRandomData(ty));
+    return generateStart(generator);
+}
+
+std::pair<syntax::Term, DataList> IncreExamplePool::generateStart(IncreDataGenerator* gen) {
     std::uniform_int_distribution<int> start_dist(0, int(start_list.size()) - 1);
-    auto& [start_name, params] = start_list[start_dist(generator->env->random_engine)];
+    auto& [start_name, params] = start_list[start_dist(gen->env->random_engine)];
+    // Global inputs and parameters are generated together, such that they can be enumerated jointly.
+    auto type_list = global_type_list;
+    type_list.insert(type_list.end(), params.begin(), params.end());
+    auto input_list = gen->getRandomDataList(type_list);
+    DataList global_inp(input_list.begin(), input_list.begin() + global_type_list.size());
     Term term = std::make_shared<TmVar>(start_name);
-    for (auto& param_type: params) {
-        auto input_data = generator->getRandomData(param_type);
-        term = std::make_shared<TmApp>(term, std::make_shared<TmValue>(input_data));
+    for (int i = global_type_list.size(); i < input_list.size(); ++i) {
+        term = std::make_shared<TmApp>(term, std::make_shared<TmValue>(input_list[i]));
     }
     return {term, global_inp};
 }
@@ -114,10 +321,18 @@ namespace {
 IncreExamplePool::IncreExamplePool(const IncreProgram &_program,
                                    const std::vector<std::vector<std::string>> &_cared_vars, IncreDataGenerator *_g):
                                    program(_program), cared_vars(_cared_vars), generator(_g), is_finished(_cared_vars.size(), false),
-                                   example_pool(cared_vars.size()), existing_example_set(cared_vars.size()){
+                                   example_pool(cared_vars.size()) {
     auto* env = generator->env;
     auto cv = env->getConstRef(config::KThreadNumName);
     thread_num = theory::clia::getIntValue(*cv);
+    is_use_arena = env->getConstRef(KIsUseArenaName, BuildData(Bool, false))->isTrue();
+    is_use_iterative = env->getConstRef(KIsUseIterativeName, BuildData(Bool, false))->isTrue();
+    bool is_exact_dedup = env->getConstRef(KIsExactDedupName, BuildData(Bool, true))->isTrue();
+    if (env->getConstRef(KIsUseMemoName, BuildData(Bool, false))->isTrue()) {
+        memo_body_list = collectPureFunctionBodies(program.get());
+        memo_capacity = theory::clia::getIntValue(*env->getConstRef(KMemoCapacityName, BuildData(Int, 4096)));
+    }
+    for (int i = 0; i < cared_vars.size(); ++i) existing_example_set.push_back(new IncreExampleDedupSet(is_exact_dedup));
 
     auto checker_gen = []() {return new types::IncreLabeledTypeChecker();};
     auto type_ctx = buildContext(_program.get(), [](){return nullptr;}, checker_gen);
@@ -140,15 +355,40 @@ IncreExamplePool::IncreExamplePool(const IncreProgram &_program,
         start_list.emplace_back(start->name, _extractStartParamList(type));
     }
     delete rewriter;
+
+    // Rewrites evaluated here are not recorded, since no global input is available when evaluating the globals.
+    auto eval_gen = [this]() -> IncreEvaluator* {
+        if (is_use_iterative) return new IncreIterativeLabeledEvaluator();
+        return new IncreLabeledEvaluator();
+    };
+    global_ctx = buildContext(program.get(), eval_gen, [](){return nullptr;});
+}
+
+IncreExampleCollector *IncreExamplePool::buildCollector() const {
+    auto* collector = new IncreExampleCollector(global_ctx, cared_vars, global_name_list, is_use_iterative);
+    if (is_use_arena) collector->enableArena();
+    if (!memo_body_list.empty()) collector->eval->enableMemo(memo_body_list, memo_capacity);
+    return collector;
 }
 
 IncreExamplePool::~IncreExamplePool() {
+    for (auto* worker_generator: worker_generator_list) delete worker_generator;
+    for (auto* example_set: existing_example_set) delete example_set;
     delete generator;
 }
 
+void IncreExamplePool::initWorkers() {
+    // Workers are built on the first batch, such that they follow the random seed set after the construction.
+    while (worker_generator_list.size() < thread_num) {
+        auto worker_env = generator->env->forkForThread();
+        worker_generator_list.push_back(generator->fork(worker_env.get()));
+        worker_env_list.push_back(worker_env);
+    }
+}
+
 void IncreExamplePool::generateSingleExample() {
     auto [term, global] = generateStart();
-    auto* collector = new IncreExampleCollector(program.get(), cared_vars, global_name_list);
+    auto* collector = buildCollector();
 
     global::recorder.start("collect");
     collector->collect(term, global);
@@ -157,74 +397,69 @@ void IncreExamplePool::generateSingleExample() {
     delete collector;
 }
 
+bool IncreExamplePool::isCachedOnly(int rewrite_id, IncreExampleCollector *collector, int start) const {
+    if (rewrite_id >= cached_key_set.size() || cached_key_set[rewrite_id].empty()) return false;
+    auto& example_list = collector->example_pool[rewrite_id];
+    for (int i = start; i < example_list.size(); ++i) {
+        if (!cached_key_set[rewrite_id].count(IncreExampleKey(example_list[i].get()))) return false;
+    }
+    return true;
+}
+
 namespace {
     const int KMaxFailedAttempt = 500;
 }
 
 void IncreExamplePool::generateBatchedExample(int rewrite_id, int target_num, TimeGuard *guard) {
     if (is_finished[rewrite_id] || target_num < example_pool[rewrite_id].size()) return;
+    initWorkers();
 
-    std::mutex input_lock, res_lock;
-    bool is_all_finished = false;
-    int attempt_num = 0;
-    std::queue<std::pair<Term, DataList>> input_queue;
+    std::atomic<bool> is_stopped(false), is_exhausted(false);
+    std::atomic<int> failed_num(0), cached_hit_num(0), example_num(example_pool[rewrite_id].size());
 
-    auto single_thread = [&](IncreExampleCollector *collector, int id) {
-        int previous_num = 0;
-        while (!guard || guard->getRemainTime() > 0) {
-            if (res_lock.try_lock()) {
-                int pre_size = example_pool[rewrite_id].size();
-
-                int total_size = 0;
-                for (auto& example_list: collector->example_pool) {
-                    total_size += example_list.size();
-                }
-                merge(rewrite_id, collector, guard);
-                collector->clear();
-                if (example_pool[rewrite_id].size() == pre_size) {
-                    attempt_num += previous_num;
-                    if (attempt_num >= KMaxFailedAttempt) {
-                        is_all_finished = true;
-                        is_finished[rewrite_id] = true;
-                    }
-                } else attempt_num = 0;
-                if (example_pool[rewrite_id].size() >= target_num || is_all_finished) {
-                    res_lock.unlock(); break;
-                }
-                res_lock.unlock();
-            }
-
-            input_lock.lock();
-            if (input_queue.empty()) {
-                int generate_num = thread_num * 100;
-                for (int i = 0; i < generate_num; ++i) {
-                    input_queue.push(generateStart());
-                }
+    // Each worker generates and runs its own inputs, and merges the examples after each run.
+    auto single_thread = [&](IncreExampleCollector *collector, IncreDataGenerator* gen) {
+        while (!is_stopped.load(std::memory_order_relaxed)) {
+            if (guard && guard->getRemainTime() <= 0) {
+                is_stopped = true; break;
             }
-            auto [start, global] = input_queue.front();
-            input_queue.pop();
-            input_lock.unlock();
-
+            auto [start, global] = generateStart(gen);
             int pre_size = collector->example_pool[rewrite_id].size();
             collector->collect(start, global);
-            if (collector->example_pool[rewrite_id].size() != pre_size)
-                previous_num++;
+            bool is_hit = collector->example_pool[rewrite_id].size() != pre_size;
+            // Runs reproducing only cached examples are expected in a run continuing from a cache, and thus they are
+            // not failures unless there are more of them than the cached examples.
+            if (is_hit && isCachedOnly(rewrite_id, collector, pre_size) &&
+                cached_hit_num.fetch_add(1) < cached_key_set[rewrite_id].size()) {
+                is_hit = false;
+            }
+
+            int new_num = merge(rewrite_id, collector, guard);
+            if (new_num) {
+                failed_num = 0;
+                if (example_num.fetch_add(new_num) + new_num >= target_num) is_stopped = true;
+            } else if (is_hit && failed_num.fetch_add(1) + 1 >= KMaxFailedAttempt) {
+                is_exhausted = true; is_stopped = true;
+            }
         }
-        return;
     };
 
     std::vector<std::thread> thread_list;
     std::vector<IncreExampleCollector*> collector_list;
 
     for (int i = 0; i < thread_num; ++i) {
-        auto *collector = new IncreExampleCollector(program.get(), cared_vars, global_name_list);
+        auto *collector = buildCollector();
         collector_list.push_back(collector);
-        thread_list.emplace_back(single_thread, collector, i);
+        thread_list.emplace_back(single_thread, collector, worker_generator_list[i]);
     }
     for (int i = 0; i < thread_num; ++i) {
         thread_list[i].join();
         delete collector_list[i];
     }
+    recordMemoryCost();
+
+    if (is_exhausted || example_pool[rewrite_id].size() < target_num) is_finished[rewrite_id] = true;
+}
 
-    if (example_pool[rewrite_id].size() < target_num) is_finished[rewrite_id] = true;
-}
\ No newline at end of file
+const std::string incre::example::KIsUseArenaName = "IncreExample@IsUseArena";
+const std::string incre::example::KIsExactDedupName = "IncreExample@IsExactDedup";
@@ -0,0 +1,289 @@
+//
+// Created by pro on 2024/3/15.
+//
+
+#include "istool/incre/analysis/incre_instru_runtime.h"
+#include "istool/incre/analysis/incre_instru_types.h"
+#include "istool/sygus/theory/basic/clia/clia_value.h"
+#include "glog/logging.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <unistd.h>
+
+using namespace incre;
+using namespace incre::syntax;
+using namespace incre::semantics;
+using namespace incre::example;
+
+/**
+ * A cache file consists of a header (magic, version and key), the number of cached runs and the progress of the
+ * generator, a table of constructor names, and the examples of each rewrite. Constructors are stored by their indices
+ * in the table, since constructor tags are interned per process.
+ */
+namespace {
+    const uint32_t KCacheMagic = 0x43504549; // "IEPC"
+    const uint32_t KCacheVersion = 2;
+
+    enum class _ValueToken: uint8_t {
+        INT, BOOL, UNIT, TUPLE, IND, COMPRESS, LABELED_COMPRESS
+    };
+
+    std::pair<uint64_t, uint64_t> _hash128(const std::string& s) {
+        // Two FNV-1a hashes with different offsets, which are stable across builds.
+        uint64_t low = 0xcbf29ce484222325ull, high = 0x84222325cbf29ce4ull;
+        for (auto c: s) {
+            low = (low ^ uint8_t(c)) * 0x100000001b3ull;
+            high = (high ^ uint8_t(c)) * 0x100000001b3ull;
+            high ^= high >> 29u;
+        }
+        return {low, high};
+    }
+
+    std::string _describeCommand(CommandData* command) {
+        std::string res = std::to_string(int(command->getType())) + " " + command->name;
+        std::vector<int> deco_list;
+        for (auto deco: command->decos) deco_list.push_back(int(deco));
+        std::sort(deco_list.begin(), deco_list.end());
+        for (auto deco: deco_list) res += " @" + std::to_string(deco);
+        switch (command->getType()) {
+            case CommandType::BIND_TERM: {
+                auto* cb = dynamic_cast<CommandBindTerm*>(command);
+                return res + (cb->is_rec ? " rec " : " ") + cb->term->toString();
+            }
+            case CommandType::DEF_IND: {
+                auto* cd = dynamic_cast<CommandDef*>(command);
+                res += " " + std::to_string(cd->param);
+                for (auto& [cons_name, cons_type]: cd->cons_list) res += " | " + cons_name + " " + cons_type->toString();
+                return res;
+            }
+            case CommandType::DECLARE: return res + " " + dynamic_cast<CommandDeclare*>(command)->type->toString();
+            case CommandType::EVAL: return res + " " + dynamic_cast<CommandEval*>(command)->term->toString();
+        }
+        return res;
+    }
+
+    class _CacheWriter {
+    public:
+        std::string buffer;
+        std::vector<std::string> cons_list;
+        std::unordered_map<int, uint32_t> cons_index_map;
+
+        template<class T> void write(T value) {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        void writeString(const std::string& s) {
+            write<uint32_t>(s.size()); buffer += s;
+        }
+        bool writeData(const Data& data) {
+            switch (data.getKind()) {
+                case DataKind::INT: {
+                    write(_ValueToken::INT); write<int32_t>(theory::clia::getIntValue(data)); return true;
+                }
+                case DataKind::BOOL: {
+                    write(_ValueToken::BOOL); write<uint8_t>(data.isTrue()); return true;
+                }
+                case DataKind::UNIT: {
+                    write(_ValueToken::UNIT); return true;
+                }
+                case DataKind::VALUE: break;
+                default: return false;
+            }
+            if (auto* vt = dynamic_cast<VTuple*>(data.get())) {
+                write(_ValueToken::TUPLE); write<uint32_t>(vt->elements.size());
+                for (auto& element: vt->elements) {
+                    if (!writeData(element)) return false;
+                }
+                return true;
+            }
+            if (auto* vi = dynamic_cast<VInd*>(data.get())) {
+                auto it = cons_index_map.find(vi->tag);
+                if (it == cons_index_map.end()) {
+                    it = cons_index_map.insert({vi->tag, cons_list.size()}).first;
+                    cons_list.push_back(getConsName(vi->tag));
+                }
+                write(_ValueToken::IND); write<uint32_t>(it->second);
+                return writeData(vi->body);
+            }
+            if (auto* vl = dynamic_cast<VLabeledCompress*>(data.get())) {
+                write(_ValueToken::LABELED_COMPRESS); write<int32_t>(vl->id);
+                return writeData(vl->body);
+            }
+            if (auto* vc = dynamic_cast<VCompress*>(data.get())) {
+                write(_ValueToken::COMPRESS);
+                return writeData(vc->body);
+            }
+            return false;
+        }
+        bool writeDataList(const DataList& data_list) {
+            write<uint32_t>(data_list.size());
+            for (auto& data: data_list) {
+                if (!writeData(data)) return false;
+            }
+            return true;
+        }
+    };
+
+    // Read the content of a cache file, where any read out of the range makes the reader invalid.
+    class _CacheReader {
+    public:
+        const char* pos;
+        const char* end;
+        bool is_valid = true;
+        std::vector<int> cons_tag_list;
+
+        _CacheReader(const char* _pos, const char* _end): pos(_pos), end(_end) {}
+        template<class T> T read() {
+            T value{};
+            if (!is_valid || end - pos < sizeof(T)) {
+                is_valid = false; return value;
+            }
+            memcpy(&value, pos, sizeof(T)); pos += sizeof(T);
+            return value;
+        }
+        std::string readString() {
+            auto size = read<uint32_t>();
+            if (!is_valid || end - pos < size) {
+                is_valid = false; return {};
+            }
+            std::string res(pos, size); pos += size;
+            return res;
+        }
+        Data readData() {
+            switch (read<_ValueToken>()) {
+                case _ValueToken::INT: return BuildData(Int, read<int32_t>());
+                case _ValueToken::BOOL: return BuildData(Bool, read<uint8_t>());
+                case _ValueToken::UNIT: return data::buildUnit();
+                case _ValueToken::TUPLE: {
+                    auto size = read<uint32_t>(); DataList elements;
+                    for (int i = 0; i < size && is_valid; ++i) elements.push_back(readData());
+                    return BuildData(Product, elements);
+                }
+                case _ValueToken::IND: {
+                    auto index = read<uint32_t>();
+                    if (index >= cons_tag_list.size()) break;
+                    auto body = readData();
+                    return Data(std::make_shared<VInd>(cons_tag_list[index], body));
+                }
+                case _ValueToken::COMPRESS: return Data(std::make_shared<VCompress>(readData()));
+                case _ValueToken::LABELED_COMPRESS: {
+                    auto id = read<int32_t>();
+                    return Data(std::make_shared<VLabeledCompress>(readData(), id));
+                }
+            }
+            is_valid = false; return data::buildUnit();
+        }
+        DataList readDataList() {
+            auto size = read<uint32_t>(); DataList res;
+            for (int i = 0; i < size && is_valid; ++i) res.push_back(readData());
+            return res;
+        }
+    };
+}
+
+std::string IncreExamplePool::getCacheKey() const {
+    std::string description;
+    for (auto& command: program->commands) description += _describeCommand(command.get()) + "\n";
+    for (auto& var_list: cared_vars) {
+        description += "cared";
+        for (auto& var: var_list) description += " " + var;
+        description += "\n";
+    }
+    description += generator->getSettingDescription();
+    auto [low, high] = _hash128(description);
+    char res[33];
+    snprintf(res, sizeof(res), "%016llx%016llx", (unsigned long long) high, (unsigned long long) low);
+    return res;
+}
+
+bool IncreExamplePool::saveCache(const std::string &path) const {
+    _CacheWriter writer;
+    for (auto& example_list: example_pool) {
+        writer.write<uint32_t>(example_list.size());
+        for (auto& example: example_list) {
+            if (!writer.writeDataList(example->local_inputs) || !writer.writeDataList(example->global_inputs) ||
+                !writer.writeData(example->oup)) {
+                LOG(WARNING) << "Cannot cache example " << example->toString();
+                return false;
+            }
+        }
+    }
+    _CacheWriter header;
+    header.write(KCacheMagic); header.write(KCacheVersion); header.writeString(getCacheKey());
+    header.write<uint32_t>(cached_run_num + 1);
+    auto progress = generator->getProgress();
+    header.write<uint32_t>(progress.size());
+    for (auto& [feature, pos]: progress) {
+        header.writeString(feature); header.write<int64_t>(pos);
+    }
+    header.write<uint32_t>(writer.cons_list.size());
+    for (auto& cons_name: writer.cons_list) header.writeString(cons_name);
+    header.write<uint32_t>(example_pool.size());
+
+    // Write to a temporary file first, such that a concurrent run never reads a partial cache.
+    auto tmp_path = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp_path, std::ios::binary);
+        out.write(header.buffer.data(), header.buffer.size());
+        out.write(writer.buffer.data(), writer.buffer.size());
+        if (!out) return false;
+    }
+    return rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+bool IncreExamplePool::loadCache(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (content.empty()) return false;
+
+    _CacheReader reader(content.data(), content.data() + content.size());
+    std::vector<IncreExampleList> loaded_pool;
+    uint32_t run_num = 0;
+    std::vector<std::pair<std::string, long long>> progress;
+    if (reader.read<uint32_t>() == KCacheMagic && reader.read<uint32_t>() == KCacheVersion && reader.readString() == getCacheKey()) {
+        run_num = reader.read<uint32_t>();
+        auto progress_num = reader.read<uint32_t>();
+        for (int i = 0; i < progress_num && reader.is_valid; ++i) {
+            auto feature = reader.readString();
+            progress.emplace_back(feature, reader.read<int64_t>());
+        }
+        auto cons_num = reader.read<uint32_t>();
+        for (int i = 0; i < cons_num && reader.is_valid; ++i) reader.cons_tag_list.push_back(getConsTag(reader.readString()));
+        auto rewrite_num = reader.read<uint32_t>();
+        if (rewrite_num != example_pool.size()) reader.is_valid = false;
+        for (int rewrite_id = 0; rewrite_id < rewrite_num && reader.is_valid; ++rewrite_id) {
+            loaded_pool.emplace_back();
+            auto example_num = reader.read<uint32_t>();
+            for (int i = 0; i < example_num && reader.is_valid; ++i) {
+                auto local_inputs = reader.readDataList();
+                auto global_inputs = reader.readDataList();
+                auto oup = reader.readData();
+                loaded_pool[rewrite_id].push_back(std::make_shared<IncreExampleData>(rewrite_id, local_inputs, global_inputs, oup));
+            }
+        }
+    } else reader.is_valid = false;
+    if (!reader.is_valid) return false;
+
+    cached_key_set.resize(example_pool.size());
+    for (int rewrite_id = 0; rewrite_id < example_pool.size(); ++rewrite_id) {
+        for (auto& example: loaded_pool[rewrite_id]) {
+            IncreExampleKey key(example.get());
+            cached_key_set[rewrite_id].insert(key);
+            if (existing_example_set[rewrite_id]->insert(key, example)) example_pool[rewrite_id].push_back(example);
+        }
+    }
+
+    // Continue the generation after the cached runs, such that this run does not regenerate the cached inputs.
+    cached_run_num = run_num;
+    generator->restoreProgress(progress);
+    auto* env = generator->env;
+    auto seed = _hash128(std::to_string(env->getRandomSeed()) + " " + std::to_string(cached_run_num)).first;
+    env->setRandomSeed(int(seed & 0x7fffffffu));
+    // Workers are forked again from the new seed in the next batch.
+    for (auto* worker_generator: worker_generator_list) delete worker_generator;
+    worker_generator_list.clear(); worker_env_list.clear();
+    return true;
+}
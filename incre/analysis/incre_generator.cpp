@@ -7,6 +7,7 @@
 #include "istool/incre/language/incre_rewriter.h"
 #include "istool/incre/analysis/incre_instru_types.h"
 #include "glog/logging.h"
+#include <typeinfo>
 
 using namespace incre;
 using namespace incre::example;
@@ -24,6 +25,17 @@ std::string IncreExampleData::toString() const {
     return res;
 }
 
+size_t IncreExampleData::hash() const {
+    auto res = data::hashCombine(std::hash<int>()(rewrite_id), data::hashDataList(local_inputs));
+    res = data::hashCombine(res, data::hashDataList(global_inputs));
+    return data::hashCombine(res, oup.hash());
+}
+
+bool IncreExampleData::operator==(const IncreExampleData &example) const {
+    return rewrite_id == example.rewrite_id && local_inputs == example.local_inputs &&
+           global_inputs == example.global_inputs && oup == example.oup;
+}
+
 IncreDataGenerator::IncreDataGenerator(Env *_env, const std::unordered_map<std::string, CommandDef *> &_cons_map):
     env(_env), cons_map(_cons_map) {
     auto* data = env->getConstRef(incre::config::KDataSizeLimitName);
@@ -44,6 +56,24 @@ Data IncreDataGenerator::getRandomInt() {
     return BuildData(Int, int_dist(env->random_engine));
 }
 
+DataList IncreDataGenerator::getRandomDataList(const syntax::TyList &type_list) {
+    DataList res;
+    for (auto& type: type_list) res.push_back(getRandomData(type));
+    return res;
+}
+
+std::string IncreDataGenerator::getSettingDescription() const {
+    return std::string(typeid(*this).name()) + " " + std::to_string(KSizeLimit) + " " + std::to_string(KIntMin) +
+           " " + std::to_string(KIntMax);
+}
+
+std::vector<std::pair<std::string, long long>> IncreDataGenerator::getProgress() const {
+    return {};
+}
+
+void IncreDataGenerator::restoreProgress(const std::vector<std::pair<std::string, long long>> &progress) {
+}
+
 SizeSafeValueGenerator::SizeSafeValueGenerator(Env *_env,
                                                const std::unordered_map<std::string, CommandDef *> &_cons_map):
         IncreDataGenerator(_env, _cons_map) {
@@ -163,7 +193,7 @@ namespace {
         for (auto& [cons_name, cons_type]: cons_it->second->cons_list) {
             auto param_type = getContentTypeForGen(type, cons_type.get());
             if (!gen->getPossibleSplit(param_type.get(), size - 1)->empty()) {
-                scheme_list->push_back(std::make_pair(cons_name, param_type));
+                scheme_list->push_back(std::make_pair(syntax::getConsTag(cons_name), param_type));
             }
         }
         return scheme_list;
@@ -178,6 +208,12 @@ namespace {
     }
 }
 
+IncreDataGenerator *SizeSafeValueGenerator::fork(Env *_env) const {
+    auto* res = new SizeSafeValueGenerator(_env, cons_map);
+    res->KSizeLimit = KSizeLimit; res->KIntMin = KIntMin; res->KIntMax = KIntMax;
+    return res;
+}
+
 SizeSplitList *SizeSafeValueGenerator::getPossibleSplit(syntax::TypeData* type, int size) {
     auto feature = type->toString() + "@" + std::to_string(size);
     auto it = split_map.find(feature);
@@ -209,7 +245,7 @@ namespace {
         return gen->getRandomBool();
     }
     GenDataHead(Unit) {
-        return Data(std::make_shared<incre::semantics::VUnit>());
+        return data::buildUnit();
     }
     GenDataHead(Tuple) {
         auto* scheme_list = gen->getPossibleSplit(type, size); assert(!scheme_list->empty());
@@ -225,9 +261,9 @@ namespace {
     GenDataHead(Ind) {
         auto* scheme_list = gen->getPossibleSplit(type, size); assert(!scheme_list->empty());
         std::uniform_int_distribution<int> choice_dist(0, int(scheme_list->size()) - 1);
-        auto& [cons_name, body_ty] = std::get<std::pair<std::string, Ty>>(scheme_list->at(choice_dist(gen->env->random_engine)));
+        auto& [cons_tag, body_ty] = std::get<std::pair<int, Ty>>(scheme_list->at(choice_dist(gen->env->random_engine)));
         auto body = _getRandomData(body_ty.get(), size - 1, gen);
-        return Data(std::make_shared<incre::semantics::VInd>(cons_name, body));
+        return Data(std::make_shared<incre::semantics::VInd>(cons_tag, body));
     }
     GenDataHead(Compress) {
         auto* labeled_type = dynamic_cast<TyLabeledCompress*>(type);
@@ -252,3 +288,276 @@ Data SizeSafeValueGenerator::getRandomData(const syntax::Ty &type) {
     }
 }
 
+
+SmallScopeValueGenerator::SmallScopeValueGenerator(Env *_env, const std::unordered_map<std::string, CommandDef *> &_cons_map,
+                                                   const std::shared_ptr<EnumerationState> &_state):
+        SizeSafeValueGenerator(_env, _cons_map), state(_state) {
+    if (!state) state = std::make_shared<EnumerationState>();
+    KEnumerateLimit = theory::clia::getIntValue(*env->getConstRef(KEnumerateLimitName, BuildData(Int, 100000)));
+}
+
+IncreDataGenerator *SmallScopeValueGenerator::fork(Env *_env) const {
+    auto* res = new SmallScopeValueGenerator(_env, cons_map, state);
+    res->KSizeLimit = KSizeLimit; res->KIntMin = KIntMin; res->KIntMax = KIntMax;
+    res->KEnumerateLimit = KEnumerateLimit;
+    return res;
+}
+
+std::string SmallScopeValueGenerator::getSettingDescription() const {
+    return SizeSafeValueGenerator::getSettingDescription() + " " + std::to_string(KEnumerateLimit);
+}
+
+std::vector<std::pair<std::string, long long>> SmallScopeValueGenerator::getProgress() const {
+    std::lock_guard<std::mutex> guard(state->lock);
+    std::vector<std::pair<std::string, long long>> res;
+    for (auto& [feature, cursor]: state->cursor_map) res.emplace_back(feature, cursor.load());
+    return res;
+}
+
+void SmallScopeValueGenerator::restoreProgress(const std::vector<std::pair<std::string, long long>> &progress) {
+    for (auto& [feature, pos]: progress) {
+        auto& cursor = getCursor(feature);
+        if (cursor.load() < pos) cursor = pos;
+    }
+}
+
+std::atomic<long long> &SmallScopeValueGenerator::getCursor(const std::string &feature) {
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->cursor_map.try_emplace(feature, 0).first->second;
+}
+
+namespace {
+    const long long KValueNumCap = 1ll << 50;
+
+    long long _addNum(long long x, long long y) {
+        return std::min(KValueNumCap, x + y);
+    }
+
+    long long _mulNum(long long x, long long y) {
+        if (x && y > KValueNumCap / x) return KValueNumCap;
+        return x * y;
+    }
+
+    TypeData* _getCompressBody(TypeData* type) {
+        auto* labeled_type = dynamic_cast<TyLabeledCompress*>(type);
+        if (!labeled_type) LOG(FATAL) << "Unexpected type " << type->toString();
+        return labeled_type->body.get();
+    }
+}
+
+long long SmallScopeValueGenerator::getValueNum(syntax::TypeData *type, int size) {
+    auto feature = type->toString() + "@" + std::to_string(size);
+    auto it = count_map.find(feature);
+    if (it != count_map.end()) return it->second;
+    long long res = 0;
+    switch (type->getType()) {
+        case TypeType::INT: res = size ? 0 : (long long) KIntMax - KIntMin + 1; break;
+        case TypeType::BOOL: res = size ? 0 : 2; break;
+        case TypeType::UNIT: res = size ? 0 : 1; break;
+        case TypeType::TUPLE: {
+            auto* tt = dynamic_cast<TyTuple*>(type);
+            for (auto& scheme: *getPossibleSplit(type, size)) {
+                auto& size_list = std::get<std::vector<int>>(scheme);
+                long long num = 1;
+                for (int i = 0; i < size_list.size(); ++i) num = _mulNum(num, getValueNum(tt->fields[i].get(), size_list[i]));
+                res = _addNum(res, num);
+            }
+            break;
+        }
+        case TypeType::IND: {
+            for (auto& scheme: *getPossibleSplit(type, size)) {
+                auto& body_type = std::get<std::pair<int, Ty>>(scheme).second;
+                res = _addNum(res, getValueNum(body_type.get(), size - 1));
+            }
+            break;
+        }
+        case TypeType::COMPRESS: res = getValueNum(_getCompressBody(type), size); break;
+        default: LOG(FATAL) << "Unexpected type in enumeration: " << type->toString();
+    }
+    return count_map[feature] = res;
+}
+
+Data SmallScopeValueGenerator::getValue(syntax::TypeData *type, int size, long long index) {
+    switch (type->getType()) {
+        case TypeType::INT: return BuildData(Int, int(KIntMin + index));
+        case TypeType::BOOL: return BuildData(Bool, index == 1);
+        case TypeType::UNIT: return data::buildUnit();
+        case TypeType::TUPLE: {
+            auto* tt = dynamic_cast<TyTuple*>(type);
+            for (auto& scheme: *getPossibleSplit(type, size)) {
+                auto& size_list = std::get<std::vector<int>>(scheme);
+                long long num = 1;
+                for (int i = 0; i < size_list.size(); ++i) num = _mulNum(num, getValueNum(tt->fields[i].get(), size_list[i]));
+                if (index >= num) {
+                    index -= num; continue;
+                }
+                DataList fields;
+                for (int i = 0; i < size_list.size(); ++i) {
+                    auto field_num = getValueNum(tt->fields[i].get(), size_list[i]);
+                    fields.push_back(getValue(tt->fields[i].get(), size_list[i], index % field_num));
+                    index /= field_num;
+                }
+                return BuildData(Product, fields);
+            }
+            break;
+        }
+        case TypeType::IND: {
+            for (auto& scheme: *getPossibleSplit(type, size)) {
+                auto& [cons_tag, body_type] = std::get<std::pair<int, Ty>>(scheme);
+                auto num = getValueNum(body_type.get(), size - 1);
+                if (index >= num) {
+                    index -= num; continue;
+                }
+                return Data(std::make_shared<incre::semantics::VInd>(cons_tag, getValue(body_type.get(), size - 1, index)));
+            }
+            break;
+        }
+        case TypeType::COMPRESS: {
+            auto body = getValue(_getCompressBody(type), size, index);
+            return Data(std::make_shared<incre::semantics::VLabeledCompress>(body, dynamic_cast<TyLabeledCompress*>(type)->id));
+        }
+        default: break;
+    }
+    LOG(FATAL) << "Cannot get the " << index << "-th value of " << type->toString() << " in size " << size;
+}
+
+DataList SmallScopeValueGenerator::getRandomDataList(const syntax::TyList &type_list) {
+    auto type = std::make_shared<TyTuple>(type_list);
+    auto index = getCursor(type->toString()).fetch_add(1);
+    for (int size = 0; size <= KSizeLimit; ++size) {
+        auto num = getValueNum(type.get(), size);
+        if (num > KEnumerateLimit) break;
+        if (index < num) {
+            auto value = getValue(type.get(), size, index);
+            return dynamic_cast<incre::semantics::VTuple*>(value.get())->elements;
+        }
+        index -= num;
+    }
+    return IncreDataGenerator::getRandomDataList(type_list);
+}
+
+UniformValueGenerator::UniformValueGenerator(Env *_env, const std::unordered_map<std::string, CommandDef *> &_cons_map):
+        SizeSafeValueGenerator(_env, _cons_map) {
+}
+
+IncreDataGenerator *UniformValueGenerator::fork(Env *_env) const {
+    auto* res = new UniformValueGenerator(_env, cons_map);
+    res->KSizeLimit = KSizeLimit; res->KIntMin = KIntMin; res->KIntMax = KIntMax;
+    return res;
+}
+
+int UniformValueGenerator::getTypeId(const syntax::Ty &type) {
+    auto it = type_id_map.find(type.get());
+    if (it != type_id_map.end()) return it->second;
+    auto name = type->toString();
+    auto name_it = type_name_map.find(name);
+    if (name_it != type_name_map.end()) {
+        alias_type_list.push_back(type);
+        return type_id_map[type.get()] = name_it->second;
+    }
+    int id = sub_type_list.size();
+    type_list.push_back(type); type_id_map[type.get()] = id; type_name_map[name] = id;
+    sub_type_list.emplace_back(); count_table.emplace_back();
+    std::vector<int> sub_types;
+    if (type->getType() == TypeType::TUPLE) {
+        for (auto& field: dynamic_cast<TyTuple*>(type.get())->fields) sub_types.push_back(getTypeId(field));
+    } else if (type->getType() == TypeType::COMPRESS) {
+        auto* labeled_type = dynamic_cast<TyLabeledCompress*>(type.get());
+        if (!labeled_type) LOG(FATAL) << "Unexpected type " << type->toString();
+        sub_types.push_back(getTypeId(labeled_type->body));
+    }
+    sub_type_list[id] = sub_types;
+    return id;
+}
+
+UniformValueGenerator::CountEntry &UniformValueGenerator::getCountEntry(int type_id, int size) {
+    if (count_table[type_id].size() <= size) count_table[type_id].resize(size + 1);
+    if (count_table[type_id][size].split_list) return count_table[type_id][size];
+    // Build the entry locally, since count_table may be reallocated by the recursive invocations.
+    auto type = type_list[type_id]; auto sub_types = sub_type_list[type_id];
+    CountEntry entry; entry.split_list = getPossibleSplit(type.get(), size);
+    switch (type->getType()) {
+        case TypeType::INT: entry.num = size ? 0 : double(KIntMax) - KIntMin + 1; break;
+        case TypeType::BOOL: entry.num = size ? 0 : 2; break;
+        case TypeType::UNIT: entry.num = size ? 0 : 1; break;
+        case TypeType::TUPLE: {
+            for (auto& scheme: *entry.split_list) {
+                auto& size_list = std::get<std::vector<int>>(scheme);
+                double num = 1;
+                for (int i = 0; i < size_list.size(); ++i) num *= getCountEntry(sub_types[i], size_list[i]).num;
+                entry.scheme_num.push_back(num); entry.num += num;
+            }
+            break;
+        }
+        case TypeType::IND: {
+            for (auto& scheme: *entry.split_list) {
+                auto content_id = getTypeId(std::get<std::pair<int, Ty>>(scheme).second);
+                double num = getCountEntry(content_id, size - 1).num;
+                entry.scheme_content.push_back(content_id);
+                entry.scheme_num.push_back(num); entry.num += num;
+            }
+            break;
+        }
+        case TypeType::COMPRESS: entry.num = getCountEntry(sub_types[0], size).num; break;
+        default: LOG(FATAL) << "Unexpected type in generation: " << type->toString();
+    }
+    return count_table[type_id][size] = entry;
+}
+
+Data UniformValueGenerator::sample(int type_id, int size) {
+    auto& entry = getCountEntry(type_id, size);
+    auto* type = type_list[type_id].get();
+    int scheme_id = 0;
+    if (!entry.scheme_num.empty()) {
+        auto value = std::uniform_real_distribution<double>(0, entry.num)(env->random_engine);
+        while (scheme_id + 1 < entry.scheme_num.size() && value >= entry.scheme_num[scheme_id]) {
+            value -= entry.scheme_num[scheme_id++];
+        }
+    }
+    switch (type->getType()) {
+        case TypeType::INT: return getRandomInt();
+        case TypeType::BOOL: return getRandomBool();
+        case TypeType::UNIT: return data::buildUnit();
+        case TypeType::TUPLE: {
+            // entry may be invalidated by sampling the fields.
+            auto size_list = std::get<std::vector<int>>(entry.split_list->at(scheme_id));
+            auto sub_types = sub_type_list[type_id];
+            DataList fields;
+            for (int i = 0; i < size_list.size(); ++i) fields.push_back(sample(sub_types[i], size_list[i]));
+            return BuildData(Product, fields);
+        }
+        case TypeType::IND: {
+            auto cons_tag = std::get<std::pair<int, Ty>>(entry.split_list->at(scheme_id)).first;
+            auto body = sample(entry.scheme_content[scheme_id], size - 1);
+            return Data(std::make_shared<incre::semantics::VInd>(cons_tag, body));
+        }
+        case TypeType::COMPRESS: {
+            auto body = sample(sub_type_list[type_id][0], size);
+            return Data(std::make_shared<incre::semantics::VLabeledCompress>(body, dynamic_cast<TyLabeledCompress*>(type)->id));
+        }
+        default: LOG(FATAL) << "Unexpected type in generation: " << type->toString();
+    }
+}
+
+double UniformValueGenerator::getValueNum(const syntax::Ty &type, int size) {
+    return getCountEntry(getTypeId(type), size).num;
+}
+
+Data UniformValueGenerator::getRandomData(const syntax::Ty &type) {
+    auto type_id = getTypeId(type);
+    auto it = size_dist_map.find(type_id);
+    if (it == size_dist_map.end()) {
+        // Each size is chosen with probability proportional to the number of its values.
+        std::vector<double> weight_list;
+        for (int size = 0; size <= KSizeLimit; ++size) weight_list.push_back(getCountEntry(type_id, size).num);
+        if (std::all_of(weight_list.begin(), weight_list.end(), [](double weight) {return weight == 0;})) {
+            LOG(FATAL) << "No value of type " << type->toString() << " is within size " << KSizeLimit;
+        }
+        it = size_dist_map.insert({type_id, std::discrete_distribution<int>(weight_list.begin(), weight_list.end())}).first;
+    }
+    return sample(type_id, it->second(env->random_engine));
+}
+
+const std::string incre::example::KIsUseSmallScopeName = "IncreExample@IsUseSmallScope";
+const std::string incre::example::KEnumerateLimitName = "IncreExample@EnumerateLimit";
+const std::string incre::example::KIsUseUniformSampleName = "IncreExample@IsUseUniformSample";
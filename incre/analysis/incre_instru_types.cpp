@@ -45,10 +45,31 @@ Ty IncreLabeledTypeRewriter::_rewrite(TyCompress *type, const Ty &_type) {
     return std::make_shared<TyLabeledCompress>(rewrite(type->body), labeled_type->id);
 }
 
+namespace {
+    std::vector<TermType> _insertLabel(std::vector<TermType> hooked_types) {
+        hooked_types.push_back(TermType::LABEL);
+        return hooked_types;
+    }
+}
+
+IncreLabeledEvaluator::IncreLabeledEvaluator(const std::vector<syntax::TermType> &hooked_types):
+    IncreCompiledEvaluator(_insertLabel(hooked_types)) {
+}
+
 Data IncreLabeledEvaluator::_evaluate(syntax::TmLabel *term, const IncreContext &ctx) {
     auto* labeled_term = dynamic_cast<TmLabeledLabel*>(term);
     if (!labeled_term) LOG(FATAL) << "Expect TmLabeledLabel, but got " << term->toString();
-    return Data(std::make_shared<VLabeledCompress>(evaluate(term->body.get(), ctx), labeled_term->id));
+    return data::makeData<VLabeledCompress>(evaluate(term->body.get(), ctx), labeled_term->id);
+}
+
+IncreIterativeLabeledEvaluator::IncreIterativeLabeledEvaluator(const std::vector<syntax::TermType> &hooked_types):
+    IncreIterativeEvaluator(hooked_types) {
+}
+
+Data IncreIterativeLabeledEvaluator::buildCompress(syntax::TmLabel *term, const Data &body) {
+    auto* labeled_term = dynamic_cast<TmLabeledLabel*>(term);
+    if (!labeled_term) LOG(FATAL) << "Expect TmLabeledLabel, but got " << term->toString();
+    return data::makeData<VLabeledCompress>(body, labeled_term->id);
 }
 
 Ty incre::types::IncreLabeledTypeChecker::_typing(syntax::TmLabel *term, const IncreContext &ctx) {
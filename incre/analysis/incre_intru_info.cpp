@@ -306,7 +306,12 @@ IncreInfo analysis::buildIncreInfo(IncreProgramData *program, Env* env) {
             cared_var_storage.push_back(cared_var_list);
         }
 
-        auto *generator = new SizeSafeValueGenerator(env, extractConsMap((res_program.get())));
+        IncreDataGenerator* generator;
+        if (env->getConstRef(KIsUseSmallScopeName, BuildData(Bool, false))->isTrue()) {
+            generator = new SmallScopeValueGenerator(env, extractConsMap(res_program.get()));
+        } else if (env->getConstRef(KIsUseUniformSampleName, BuildData(Bool, false))->isTrue()) {
+            generator = new UniformValueGenerator(env, extractConsMap(res_program.get()));
+        } else generator = new SizeSafeValueGenerator(env, extractConsMap((res_program.get())));
         example_pool = new IncreExamplePool(res_program, cared_var_storage, generator);
     }
 
@@ -314,6 +319,7 @@ IncreInfo analysis::buildIncreInfo(IncreProgramData *program, Env* env) {
     theory::loadBasicSemantics(env, TheoryToken::CLIA);
     ext::ho::loadDeepCoderSemantics(env);
     incre::semantics::registerIncreExecutionInfo(env, example_pool->global_name_list);
+    incre::semantics::enableIncreOperatorMemo(env, res_program.get());
 
     auto component_pool = incre::grammar::collector::collectComponent(env, res_program.get());
 
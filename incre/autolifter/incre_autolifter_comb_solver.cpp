@@ -31,7 +31,7 @@ namespace {
                 auto* cv = dynamic_cast<VCompress*>(res.get());
                 if (cv) {
                     try {
-                        return env->run(program.second.get(), data::concatDataList({cv->body}, global_inputs));
+                        return env->run(program.second.get(), ParamView(&cv->body, 1, global_inputs.data(), int(global_inputs.size())));
                     } catch (SemanticsError& e) {
                         return {};
                     }
@@ -109,7 +109,7 @@ namespace {
             if (type->getType() == TypeType::COMPRESS) {
                 auto* ct = dynamic_cast<TyLabeledCompress*>(type.get());
                 assert(ct); int num = f_res_list[ct->id].component_list.size();
-                if (!num) return Data(std::make_shared<VUnit>());
+                if (!num) return data::buildUnit();
                 if (num == 1) return oup_cache_list[cache_id++].second->at(example_id);
                 DataList elements(num);
                 for (int i = 0; i < num; ++i) elements[i] = oup_cache_list[cache_id++].second->at(example_id);
@@ -232,7 +232,7 @@ namespace {
 
         bool isValid(const PProgram& program) {
             for (auto& example: example_list) {
-                if (!(env->run(program.get(), data::concatDataList(example->local_inputs, example->global_inputs)) == example->oup)) {
+                if (!(env->run(program.get(), ParamView(example->local_inputs, example->global_inputs)) == example->oup)) {
                     return false;
                 }
             }
@@ -244,7 +244,7 @@ namespace {
         if (type->getType() == TypeType::COMPRESS) {
             auto* ct = dynamic_cast<TyLabeledCompress*>(type); assert(ct);
             int size = f_res_list[ct->id].component_list.size();
-            if (size == 0) return program::buildConst(Data(std::make_shared<VUnit>()));
+            if (size == 0) return program::buildConst(data::buildUnit());
             if (size == 1) return program_list[pos++];
             ProgramList sub_list;
             for (int i = 0; i < size; ++i) sub_list.push_back(program_list[pos++]);
@@ -473,7 +473,7 @@ TermList IncreAutoLifterSolver::buildFRes() {
         }
 
         if (fields.empty()) {
-            auto data = Data(std::make_shared<VUnit>());
+            auto data = data::buildUnit();
             result.push_back(std::make_shared<TmValue>(data));
         } else if (fields.size() == 1) {
             result.push_back(std::make_shared<TmFunc>(compress_name, fields[0]));
@@ -145,7 +145,7 @@ IncreAutoLifterSolver::~IncreAutoLifterSolver() {
 }
 bool FRes::isEqual(Program *x, Program *y) {
     //TODO: add a semantical check
-    return x->toString() == y->toString();
+    return x->getFingerprint() == y->getFingerprint();
 }
 int FRes::insert(const TypedProgram& program) {
     for (int i = 0; i < component_list.size(); ++i) {
@@ -159,7 +159,7 @@ int FRes::insert(const TypedProgram& program) {
 
 bool CompressRes::isEqual(Program* x, Program* y) {
     // TODO: add a semantical check
-    return x->toString() == y->toString();
+    return x->getFingerprint() == y->getFingerprint();
 }
 int CompressRes::insert(const TypedProgram& program) {
     for (int i = 0; i < compress_list.size(); ++i) {
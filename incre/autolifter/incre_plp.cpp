@@ -53,8 +53,17 @@ FExampleSpace::FExampleSpace(IncreExamplePool *_pool, int _rewrite_id, const PEn
 
 void FExampleSpace::extendAuxCache(const AuxProgram &program, DataList *cache_item, int length) {
     assert(length <= example_list.size());
+    if (cache_item->size() >= length) return;
+    CompiledProgram extract(program.first.second);
+    std::unique_ptr<CompiledProgram> aux;
+    if (program.second.second) aux = std::make_unique<CompiledProgram>(program.second.second);
     for (int i = cache_item->size(); i < length; ++i) {
-        cache_item->push_back(runAux(i, program));
+        auto res = runExtract(i, &extract);
+        if (aux) {
+            auto* tv = dynamic_cast<incre::semantics::VLabeledCompress*>(res.get());
+            res = runAux(i, tv->body, aux.get());
+        }
+        cache_item->push_back(res);
     }
 }
 void FExampleSpace::extendOupCache(const PProgram &program, const std::vector<int> &path, DataList *cache_item,
@@ -67,7 +76,7 @@ void FExampleSpace::extendOupCache(const PProgram &program, const std::vector<in
 }
 
 DataList *FExampleSpace::getAuxCache(const AuxProgram &program, int length) {
-    auto feature = aux2String(program);
+    auto feature = aux2Fingerprint(program);
     if (aux_cache.find(feature) == aux_cache.end()) return nullptr;
     auto* cache_item = aux_cache[feature];
     extendAuxCache(program, cache_item, length);
@@ -75,17 +84,11 @@ DataList *FExampleSpace::getAuxCache(const AuxProgram &program, int length) {
 }
 
 namespace {
-    std::string _path2String(const std::vector<int>& path) {
-        std::string res = "[";
-        for (int i = 0; i < path.size(); ++i) {
-            if (i) res += ","; res += std::to_string(path[i]);
-        }
-        return res + "]";
-    }
-
-    std::string _getOupFeature(const PProgram& program, const std::vector<int>& path) {
-        if (program) return program->toString() + "@" + _path2String(path);
-        return _path2String(path);
+    uint64_t _getOupFeature(const PProgram& program, const std::vector<int>& path) {
+        uint64_t res = program ? program->getFingerprint() : 0;
+        res = ::semantics::combineFingerprint(res, path.size());
+        for (auto pos: path) res = ::semantics::combineFingerprint(res, pos);
+        return res;
     }
 }
 
@@ -98,7 +101,7 @@ DataList* FExampleSpace::getOupCache(const PProgram &program, const std::vector<
 }
 
 void FExampleSpace::registerAuxCache(const AuxProgram &program, const DataList &oup_list) {
-    auto feature = aux2String(program);
+    auto feature = aux2Fingerprint(program);
     assert(aux_cache.find(feature) == aux_cache.end());
     auto* cache_item = new DataList(oup_list);
     aux_cache[feature] = cache_item;
@@ -129,14 +132,29 @@ namespace {
 Data FExampleSpace::runExtract(int example_id, Program *prog) {
     global::recorder.start("execute");
     auto& example = example_list[example_id];
-    auto res = env->run(prog, data::concatDataList(example->local_inputs, example->global_inputs));
+    auto res = env->run(prog, ParamView(example->local_inputs, example->global_inputs));
     global::recorder.end("execute");
     return res;
 }
 Data FExampleSpace::runAux(int example_id, const Data& content, Program *prog) {
     global::recorder.start("execute");
     auto& example = example_list[example_id];
-    auto res = env->run(prog, data::concatDataList({content}, example->global_inputs));
+    auto res = env->run(prog, ParamView(&content, 1, example->global_inputs.data(), int(example->global_inputs.size())));
+    global::recorder.end("execute");
+    return res;
+}
+
+Data FExampleSpace::runExtract(int example_id, CompiledProgram *prog) {
+    global::recorder.start("execute");
+    auto& example = example_list[example_id];
+    auto res = env->run(prog, ParamView(example->local_inputs, example->global_inputs));
+    global::recorder.end("execute");
+    return res;
+}
+Data FExampleSpace::runAux(int example_id, const Data& content, CompiledProgram *prog) {
+    global::recorder.start("execute");
+    auto& example = example_list[example_id];
+    auto res = env->run(prog, ParamView(&content, 1, example->global_inputs.data(), int(example->global_inputs.size())));
     global::recorder.end("execute");
     return res;
 }
@@ -219,7 +237,7 @@ Data incre::autolifter::eliminateCompress(const Data &data) {
     }
     {
         ValueHead(Ind) {
-            return Data(std::make_shared<incre::semantics::VInd>(v->name, eliminateCompress(v->body)));
+            return Data(std::make_shared<incre::semantics::VInd>(v->tag, eliminateCompress(v->body)));
         }
     }
     LOG(FATAL) << "Unknown data " << data.toString();
@@ -238,6 +256,16 @@ std::string incre::autolifter::aux2String(const AuxProgram &program) {
         return /*program.first.first->getName() + "@" +*/ program.first.second->toString() + " -> " + program.second.second->toString();
     }
 }
+uint64_t incre::autolifter::aux2Fingerprint(const AuxProgram &program) {
+    if (!program.second.first) {
+        auto res = std::hash<std::string>()(program.first.first->getName());
+        return ::semantics::combineFingerprint(res, program.first.second->getFingerprint());
+    } else {
+        auto res = ::semantics::combineFingerprint(program.first.second->getFingerprint(), program.second.second->getFingerprint());
+        // Separate from the fingerprints of the single programs above.
+        return ::semantics::combineFingerprint(res, 1);
+    }
+}
 namespace {
     TypedProgram _extractTypedProgram(const PProgram& program) {
         auto* ts = dynamic_cast<incre::semantics::TypeLabeledDirectSemantics*>(program->semantics.get());
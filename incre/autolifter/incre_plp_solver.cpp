@@ -115,10 +115,12 @@ namespace {
     int KDefaultEnlargeFactor = 2;
     bool KDefaultIsMergeVar = true;
     bool KDefaultIsIncludeDirect = false;
+    int KDefaultEvaluationFuel = 1000000;
 }
 
 const std::string incre::autolifter::KIsMergeVarName = "IncreAutoLifter@IsMergeVar";
 const std::string incre::autolifter::KIsIncludeDirectValueName = "IncreAutoLifter@IsIncludeVar";
+const std::string incre::autolifter::KEvaluationFuelName = "IncreAutoLifter@EvaluationFuel";
 
 IncrePLPSolver::IncrePLPSolver(Env *_env, PLPTask *_task): env(_env), task(_task) {
     auto* d = env->getConstRef(solver::autolifter::KComposedNumName, BuildData(Int, KDefaultComposedNum));
@@ -129,6 +131,8 @@ IncrePLPSolver::IncrePLPSolver(Env *_env, PLPTask *_task): env(_env), task(_task
     KVerifyBaseNum = theory::clia::getIntValue(*d);
     KExampleTimeOut = KDefaultExampleTimeOut;
     KExampleEnlargeFactor = KDefaultEnlargeFactor;
+    d = env->getConstRef(KEvaluationFuelName, BuildData(Int, KDefaultEvaluationFuel));
+    KEvaluationFuel = theory::clia::getIntValue(*d);
 
     d = env->getConstRef(KIsMergeVarName, BuildData(Bool, KDefaultIsMergeVar));
     auto is_var = env->getConstRef(KIsIncludeDirectValueName, BuildData(Bool, KDefaultIsIncludeDirect));
@@ -160,6 +164,8 @@ namespace {
 }
 
 UnitInfo IncrePLPSolver::init(const AuxProgram& program) {
+    // Components running out of fuel are dropped as those failing on the examples.
+    EvaluationFuelScope fuel_scope(task->example_space->env, KEvaluationFuel);
     for (auto& example: error_example_list) {
         try {
             evaluate_util->execute(program, example);
@@ -187,10 +193,10 @@ std::string IncrePLPSolver::example2String(const std::pair<int, int> &example) {
 }
 
 std::vector<AuxProgram> IncrePLPSolver::unfoldComponents(const std::vector<AuxProgram> &program_list) {
-    std::unordered_set<std::string> existing_set;
+    std::unordered_set<uint64_t> existing_set;
     std::vector<AuxProgram> result;
     auto insert = [&](const AuxProgram& program) {
-        auto feature = autolifter::aux2String(program);
+        auto feature = autolifter::aux2Fingerprint(program);
         if (existing_set.find(feature) != existing_set.end()) return;
         existing_set.insert(feature);
         result.push_back(program);
@@ -382,12 +388,27 @@ std::pair<int, int> IncrePLPSolver::verify(const std::vector<AuxProgram> &aux_li
 
     std::vector<DataList*> inp_cache_list(aux_list.size(), nullptr);
     DataStorage new_inp_storage(aux_list.size());
-    for (int i = 0; i < aux_list.size(); ++i) {
-        inp_cache_list[i] = task->example_space->getAuxCache(aux_list[i], verify_num);
-    }
+    // Extending the caches of auxiliary programs runs them as well, and thus it is done under the fuel budget. The
+    // first example on which some program fails is returned, and -1 is returned if all programs succeed.
+    auto extend_cache = [&](int length) {
+        EvaluationFuelScope fuel_scope(task->example_space->env, KEvaluationFuel);
+        for (int i = 0; i < aux_list.size(); ++i) {
+            try {
+                if (!inp_cache_list[i]) inp_cache_list[i] = task->example_space->getAuxCache(aux_list[i], length);
+                else task->example_space->extendAuxCache(aux_list[i], inp_cache_list[i], length);
+            } catch (const SemanticsError& e) {
+                // The cache keeps the results before the failed example.
+                if (!inp_cache_list[i]) inp_cache_list[i] = task->example_space->getAuxCache(aux_list[i], 0);
+                return int(inp_cache_list[i]->size());
+            }
+        }
+        return -1;
+    };
+    auto failed_id = extend_cache(verify_num);
+    if (failed_id >= 0) return {failed_id, failed_id};
     DataList* oup_cache = task->oup_cache; task->extendOupCache(verify_num);
 
-    std::unordered_map<std::string, std::pair<Data, int>> verify_cache;
+    std::unordered_map<DataList, std::pair<Data, int>, data::DataListHash> verify_cache;
 
     auto deal_example = [&](int example_id) {
         auto oup = oup_cache->at(example_id);
@@ -405,12 +426,12 @@ std::pair<int, int> IncrePLPSolver::verify(const std::vector<AuxProgram> &aux_li
                 }
             }
         }
-        auto feature = data::dataList2String(inp_list);
-        if (verify_cache.find(feature) == verify_cache.end()) {
-            verify_cache[feature] = {oup, example_id};
+        auto it = verify_cache.find(inp_list);
+        if (it == verify_cache.end()) {
+            verify_cache.insert({std::move(inp_list), {oup, example_id}});
             return -1;
         } else {
-            auto& [pre_oup, pre_id] = verify_cache[feature];
+            auto& [pre_oup, pre_id] = it->second;
             if (pre_oup == oup) return -1;
             return pre_id;
         }
@@ -418,12 +439,17 @@ std::pair<int, int> IncrePLPSolver::verify(const std::vector<AuxProgram> &aux_li
 
     LOG(INFO) << "Prepare finished";
 
-    for (int try_num = 0; try_num < verify_num; ++try_num) {
-        verify_pos = (verify_pos + 1) % verify_num;
-        auto pre_id = deal_example(verify_pos);
-        if (pre_id >= 0) {
-            LOG(INFO) << "Find a counterexample after " << try_num << "/" << verify_num;
-            return {pre_id, verify_pos};
+    // An example on which some auxiliary program runs out of fuel is returned as a counterexample, such that the
+    // program is dropped by init in the next turn. The same applies to the failures when extending caches.
+    {
+        EvaluationFuelScope fuel_scope(task->example_space->env, KEvaluationFuel);
+        for (int try_num = 0; try_num < verify_num; ++try_num) {
+            verify_pos = (verify_pos + 1) % verify_num;
+            auto pre_id = deal_example(verify_pos);
+            if (pre_id >= 0) {
+                LOG(INFO) << "Find a counterexample after " << try_num << "/" << verify_num;
+                return {pre_id, verify_pos};
+            }
         }
     }
 
@@ -447,16 +473,16 @@ std::pair<int, int> IncrePLPSolver::verify(const std::vector<AuxProgram> &aux_li
     verify_num = verify_num * KExampleEnlargeFactor;
     verify_num = task->acquireExample(verify_num, KExampleTimeOut);
 
-    for (int i = 0; i < aux_list.size(); ++i) {
-        if (inp_cache_list[i]) {
-            task->example_space->extendAuxCache(aux_list[i], inp_cache_list[i], verify_num);
-        }
-    }
+    failed_id = extend_cache(verify_num);
+    if (failed_id >= 0) return {failed_id, failed_id};
     task->extendOupCache(verify_num);
 
-    for (verify_pos = pre_verify_num; verify_pos < verify_num; ++verify_pos) {
-        auto pre_id = deal_example(verify_pos);
-        if (pre_id >= 0) return {pre_id, verify_pos};
+    {
+        EvaluationFuelScope fuel_scope(task->example_space->env, KEvaluationFuel);
+        for (verify_pos = pre_verify_num; verify_pos < verify_num; ++verify_pos) {
+            auto pre_id = deal_example(verify_pos);
+            if (pre_id >= 0) return {pre_id, verify_pos};
+        }
     }
 
     for (int i = 0; i < aux_list.size(); ++i) {
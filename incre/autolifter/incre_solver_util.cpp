@@ -40,16 +40,16 @@ std::pair<SolverToken, InvokeConfig> util::getSolverToken(Type *oup_type) {
 
 namespace {
     bool _isDistinguishAllExamples(const std::vector<bool>& is_used, const IOExampleList& example_list) {
-        std::unordered_map<std::string, Data> example_map;
+        std::unordered_map<DataList, Data, data::DataListHash> example_map;
         for (auto& [inp, oup]: example_list) {
             DataList sim_inp;
             for (int i = 0; i < is_used.size(); ++i) {
                 if (is_used[i]) sim_inp.push_back(inp[i]);
             }
-            auto feature = data::dataList2String(sim_inp);
-            if (example_map.find(feature) == example_map.end()) {
-                example_map[feature] = oup;
-            } else if (!(oup == example_map[feature])) {
+            auto it = example_map.find(sim_inp);
+            if (it == example_map.end()) {
+                example_map.insert({std::move(sim_inp), oup});
+            } else if (!(oup == it->second)) {
                 return false;
             }
         }
@@ -122,7 +122,7 @@ namespace {
 PProgram util::synthesis2Program(const TypeList &inp_type_list, const PType &oup_type, const PEnv &env, Grammar* grammar,
                                  const IOExampleList &example_list) {
     if (dynamic_cast<TBot*>(oup_type.get())) {
-        return program::buildConst(Data(std::make_shared<incre::semantics::VUnit>()));
+        return program::buildConst(data::buildUnit());
     }
     LOG(INFO) << "try synthesis";
     for (int i = 0; i < 10 && i < example_list.size(); ++i) {
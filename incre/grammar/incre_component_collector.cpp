@@ -80,6 +80,7 @@ namespace {
                 name_last_id_map[name] = command_id;
                 auto* address = ctx.getAddress(name);
                 auto cons_term = std::make_shared<TmFunc>("x", std::make_shared<TmCons>(name, std::make_shared<TmVar>("x")));
+                incre::semantics::resolveTerm(cons_term.get(), ctx);
                 auto data = evaluator->evaluate(cons_term.get(), ctx);
                 component_info_list.emplace_back(command_id, name, data, address->bind.getType(), command);
             }
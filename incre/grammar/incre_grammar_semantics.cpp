@@ -3,39 +3,76 @@
 //
 
 #include "istool/incre/grammar/incre_grammar_semantics.h"
+#include "istool/sygus/theory/basic/clia/clia_value.h"
 #include "glog/logging.h"
 
 using namespace incre::semantics;
 using namespace incre::syntax;
 
-incre::semantics::IncreGloablExternalEvaluator::IncreGloablExternalEvaluator(
-        const std::unordered_map<std::string, Data> &_global_input): global_input(_global_input) {
+incre::semantics::IncreGlobalInput::IncreGlobalInput(const std::vector<std::string> *_global_name, const ParamView &_param):
+    global_name(_global_name), param(_param) {
 }
 
-Data incre::semantics::IncreGloablExternalEvaluator::_evaluate(syntax::TmVar *term, const IncreContext &ctx) {
-    for (auto pos = ctx.start; pos; pos = pos->next) {
-        if (pos->name == term->name) {
-            if (!pos->bind.data.isNull()) return pos->bind.data;
-            auto it = global_input.find(term->name);
-            if (it != global_input.end()) return it->second;
-        }
+Data incre::semantics::IncreGlobalInput::get(const std::string &name) const {
+    if (!global_name) return {};
+    int start = param.size() - int(global_name->size());
+    for (int i = 0; i < global_name->size(); ++i) {
+        if (global_name->at(i) == name) return param[start + i];
     }
-    throw incre::semantics::IncreSemanticsError("Unknown variable " + term->name);
+    return {};
+}
+
+incre::semantics::IncreGloablExternalEvaluator::IncreGloablExternalEvaluator(const IncreGlobalInput *_input): input(_input) {
+}
+
+Data incre::semantics::IncreGloablExternalEvaluator::_evaluate(syntax::TmVar *term, const IncreContext &ctx) {
+    auto res = ctx.getData(term);
+    if (!res.isNull()) return res;
+    res = input->get(term->name);
+    if (res.isNull()) throw incre::semantics::IncreSemanticsError("Unknown variable " + term->name);
+    return res;
+}
+
+incre::semantics::IncreIterativeGlobalExternalEvaluator::IncreIterativeGlobalExternalEvaluator(const IncreGlobalInput *_input):
+    input(_input) {
+}
+
+Data incre::semantics::IncreIterativeGlobalExternalEvaluator::_evaluate(syntax::TmVar *term, const IncreContext &ctx) {
+    auto res = input->get(term->name);
+    if (res.isNull()) throw incre::semantics::IncreSemanticsError("Unknown variable " + term->name);
+    return res;
+}
+
+incre::semantics::IncreExecutionInfo::IncreExecutionInfo(const ParamView &_param_list,
+                                                         const std::vector<std::string>* global_name, bool is_iterative):
+                                                         ExecuteInfo(_param_list, {}), input(global_name, _param_list) {
+    if (is_iterative) eval = new IncreIterativeGlobalExternalEvaluator(&input);
+    else eval = new IncreGloablExternalEvaluator(&input);
 }
 
-incre::semantics::IncreExecutionInfo::IncreExecutionInfo(const DataList &_param_list,
-                                                         const std::unordered_map<std::string, Data> &global_input):
-                                                         ExecuteInfo(_param_list, {}) {
-    eval = new IncreGloablExternalEvaluator(global_input);
+void incre::semantics::IncreExecutionInfo::setInput(const ParamView &_param_list, const std::vector<std::string> *global_name) {
+    param_value = _param_list;
+    input = IncreGlobalInput(global_name, _param_list);
+    // Memoized results of top-level closures may read the global inputs.
+    if (global_name && !global_name->empty()) eval->clearMemo();
 }
+
 incre::semantics::IncreExecutionInfo::~IncreExecutionInfo() noexcept {
     delete eval;
 }
 
 Data incre::semantics::invokeApp(const Data &func, const DataList &param_list, IncreExecutionInfo *info) {
-    Term full_term = std::make_shared<TmValue>(func);
-    for (auto& param: param_list) full_term = std::make_shared<TmApp>(full_term, std::make_shared<TmValue>(param));
-    return info->eval->evaluate(full_term.get(), IncreContext(nullptr));
+    if (param_list.empty()) return func;
+    auto* vc = dynamic_cast<VClosure*>(func.get());
+    if (!vc) throw IncreSemanticsError("expected a closure when applying parameters, but got " + func.toString());
+    // The incre evaluator draws from the fuel of the execution.
+    auto* eval = info->eval; eval->fuel = info->fuel;
+    try {
+        auto res = eval->applyClosure(vc, param_list);
+        info->fuel = eval->fuel; return res;
+    } catch (...) {
+        info->fuel = eval->fuel; throw;
+    }
 }
 
 incre::semantics::IncreOperatorSemantics::IncreOperatorSemantics(const std::string &name, const Data &_func):
@@ -48,29 +85,31 @@ Data incre::semantics::IncreOperatorSemantics::run(DataList &&inp_list, ExecuteI
     try {
         return incre::semantics::invokeApp(func, inp_list, incre_info);
     } catch (const IncreSemanticsError& e) {
-        throw SemanticsError();
+        return data::buildError();
     }
 }
 
-incre::semantics::IncreExecutionInfoBuilder::IncreExecutionInfoBuilder(const std::vector<std::string> &_global_name):
-    global_name(_global_name), is_enable(true) {
+incre::semantics::IncreExecutionInfoBuilder::IncreExecutionInfoBuilder(const std::vector<std::string> &_global_name, bool _is_iterative):
+    global_name(_global_name), is_enable(true), is_iterative(_is_iterative), memo_capacity(0) {
 }
 
 ExecuteInfo *
-incre::semantics::IncreExecutionInfoBuilder::buildInfo(const DataList &_param_value, const FunctionContext &ctx) {
-    if (!is_enable) {
-        return new IncreExecutionInfo(_param_value, {});
-    }
-    std::unordered_map<std::string, Data> global_input;
-    int start = int(_param_value.size()) - int(global_name.size());
-    for (int i = 0; i < global_name.size(); ++i) {
-        global_input[global_name[i]] = _param_value[start + i];
-    }
-    return new IncreExecutionInfo(_param_value, global_input);
+incre::semantics::IncreExecutionInfoBuilder::buildInfo(const ParamView &_param_value, const FunctionContext &ctx) {
+    auto* info = new IncreExecutionInfo(_param_value, is_enable ? &global_name : nullptr, is_iterative);
+    if (!memo_body_list.empty()) info->eval->enableMemo(memo_body_list, memo_capacity);
+    return info;
+}
+
+void incre::semantics::IncreExecutionInfoBuilder::resetInfo(ExecuteInfo *info, const ParamView &_param_value,
+                                                            const FunctionContext &ctx) {
+    auto* incre_info = dynamic_cast<IncreExecutionInfo*>(info);
+    if (!incre_info) LOG(FATAL) << "IncreExecutionInfoBuilder can only reset IncreExecutionInfo";
+    incre_info->setInput(_param_value, is_enable ? &global_name : nullptr);
 }
 
 void incre::semantics::registerIncreExecutionInfo(Env* env, const std::vector<std::string> &global_names) {
-    env->setExecuteInfoBuilder(new IncreExecutionInfoBuilder(global_names));
+    bool is_iterative = env->getConstRef(KIsUseIterativeName, BuildData(Bool, false))->isTrue();
+    env->setExecuteInfoBuilder(new IncreExecutionInfoBuilder(global_names, is_iterative));
 }
 
 void incre::semantics::isConsiderGlobalInputs(Env* env, bool new_flag) {
@@ -79,6 +118,14 @@ void incre::semantics::isConsiderGlobalInputs(Env* env, bool new_flag) {
     builder->is_enable = new_flag;
 }
 
+void incre::semantics::enableIncreOperatorMemo(Env *env, IncreProgramData *program) {
+    if (!env->getConstRef(KIsUseMemoName, BuildData(Bool, false))->isTrue()) return;
+    auto* builder = dynamic_cast<IncreExecutionInfoBuilder*>(env->getExecuteInfoBuilder());
+    if (!builder) LOG(FATAL) << "The currect builder is not IncreExecutionInfoBuilder";
+    builder->memo_body_list = collectPureFunctionBodies(program);
+    builder->memo_capacity = theory::clia::getIntValue(*env->getConstRef(KMemoCapacityName, BuildData(Int, 4096)));
+}
+
 TypeLabeledDirectSemantics::TypeLabeledDirectSemantics(const PType &_type): NormalSemantics(_type->getName(), _type, {_type}), type(_type) {
 }
 Data TypeLabeledDirectSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
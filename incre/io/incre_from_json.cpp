@@ -158,7 +158,7 @@ namespace {
         Data v;
         if (name == "true") v = BuildData(Bool, false);
         else if (name == "false") v = BuildData(Bool, true);
-        else if (name == "unit") v = Data(std::make_shared<VUnit>());
+        else if (name == "unit") v = data::buildUnit();
         else if (name == "int") v = BuildData(Int, node["value"].asInt());
         else throw IncreParseError("Unknown value " + name);
         return std::make_shared<TmValue>(v);
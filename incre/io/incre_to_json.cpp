@@ -211,7 +211,7 @@ namespace {
             auto *vc = dynamic_cast<incre::semantics::VInd *>(term->v.get());
             if (vc) {
                 InitJsonWithType("cons");
-                value["name"] = vc->name;
+                value["name"] = vc->getName();
                 auto body = std::make_shared<TmValue>(vc->body);
                 value["body"] = _term2json_Value(body.get(), indices);
                 return value;
@@ -0,0 +1,641 @@
+//
+// Created by pro on 2024/3/12.
+//
+
+#include "istool/incre/language/incre_compiled_semantics.h"
+#include "glog/logging.h"
+#include <algorithm>
+#include <unordered_set>
+
+using namespace incre;
+using namespace incre::semantics;
+using namespace incre::syntax;
+
+VCompiledClosure::VCompiledClosure(const IncreContext &_context, const std::string &_name, const syntax::Term &_body,
+                                   const syntax::VarScope *_scope, const CompiledTerm &_compiled_body, int _hook_mask):
+                                   VClosure(_context, _name, _body, _scope), compiled_body(_compiled_body), hook_mask(_hook_mask) {
+}
+
+namespace {
+    class CValue: public CompiledTermData {
+    public:
+        Data v;
+        CValue(const Data& _v): v(_v) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {return v;}
+    };
+
+    // A variable that is not resolved, which is evaluated by the interpreter.
+    class CNamedVar: public CompiledTermData {
+    public:
+        TmVar* var;
+        CNamedVar(TmVar* _var): var(_var) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            return eval->interpret(var, ctx);
+        }
+    };
+
+    class CLocalVar: public CNamedVar {
+    public:
+        int depth, slot;
+        const VarScope* scope;
+        CLocalVar(TmVar* _var): CNamedVar(_var), depth(_var->depth), slot(_var->slot), scope(_var->scope) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto* frame = ctx.frame.get();
+            for (int i = 0; frame && i < depth; ++i) frame = frame->parent.get();
+            if (frame && frame->scope == scope) return frame->slot_list[slot];
+            return CNamedVar::run(ctx, eval);
+        }
+    };
+
+    class CGlobalVar: public CNamedVar {
+    public:
+        int index;
+        CGlobalVar(TmVar* _var): CNamedVar(_var), index(_var->slot) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto* address = ctx.getGlobal(index);
+            if (address && address->name == var->name && !address->bind.data.isNull()) return address->bind.data;
+            return CNamedVar::run(ctx, eval);
+        }
+    };
+
+    typedef Data(*PrimaryOperator)(const Data&, const Data&);
+
+#define INT_OPERATOR(sop, op, oup) {sop, [](const Data& x, const Data& y) {return BuildData(oup, theory::clia::getIntValue(x) op theory::clia::getIntValue(y));}}
+#define BOOL_OPERATOR(sop, op) {sop, [](const Data& x, const Data& y) {return BuildData(Bool, x.isTrue() op y.isTrue());}}
+
+    // Operators with two operands, which agree with invokePrimary.
+    const std::unordered_map<std::string, PrimaryOperator> KBinaryOperatorMap = {
+            INT_OPERATOR("+", +, Int), INT_OPERATOR("-", -, Int), INT_OPERATOR("*", *, Int), INT_OPERATOR("/", /, Int),
+            INT_OPERATOR("<", <, Bool), INT_OPERATOR("<=", <=, Bool), INT_OPERATOR(">", >, Bool), INT_OPERATOR(">=", >=, Bool),
+            {"==", [](const Data& x, const Data& y) {return BuildData(Bool, x == y);}},
+            BOOL_OPERATOR("and", &&), BOOL_OPERATOR("or", ||)
+    };
+
+    class CBinaryPrimary: public CompiledTermData {
+    public:
+        PrimaryOperator op;
+        CompiledTerm x, y;
+        CBinaryPrimary(PrimaryOperator _op, const CompiledTerm& _x, const CompiledTerm& _y): op(_op), x(_x), y(_y) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto x_res = x->run(ctx, eval);
+            return op(x_res, y->run(ctx, eval));
+        }
+    };
+
+    class CPrimary: public CompiledTermData {
+    public:
+        std::string op_name;
+        std::vector<CompiledTerm> param_list;
+        CPrimary(const std::string& _op_name, const std::vector<CompiledTerm>& _param_list): op_name(_op_name), param_list(_param_list) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            DataList params;
+            for (auto& param: param_list) params.push_back(param->run(ctx, eval));
+            return invokePrimary(op_name, params);
+        }
+    };
+
+    class CIf: public CompiledTermData {
+    public:
+        CompiledTerm c, t, f;
+        CIf(const CompiledTerm& _c, const CompiledTerm& _t, const CompiledTerm& _f): c(_c), t(_t), f(_f) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            if (c->run(ctx, eval).isTrue()) return t->run(ctx, eval);
+            return f->run(ctx, eval);
+        }
+    };
+
+    class CApp: public CompiledTermData {
+    public:
+        CompiledTerm func, param;
+        CApp(const CompiledTerm& _func, const CompiledTerm& _param): func(_func), param(_param) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto func_res = func->run(ctx, eval);
+            return eval->apply(func_res, param->run(ctx, eval));
+        }
+    };
+
+    class CFunc: public CompiledTermData {
+    public:
+        TmFunc* term;
+        const VarScope* scope;
+        CompiledTerm body;
+        CFunc(TmFunc* _term, const CompiledTerm& _body): term(_term), scope(getFrameScope(_term)), body(_body) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            return data::makeData<VCompiledClosure>(ctx, term->name, term->body, scope, body, eval->getHookMask());
+        }
+    };
+
+    class CLet: public CompiledTermData {
+    public:
+        bool is_rec;
+        const VarScope* scope;
+        CompiledTerm def, body;
+        CLet(bool _is_rec, const VarScope* _scope, const CompiledTerm& _def, const CompiledTerm& _body):
+            is_rec(_is_rec), scope(_scope), def(_def), body(_body) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            if (is_rec) {
+                auto new_ctx = ctx.pushFrame(scope);
+                new_ctx.frame->slot_list[0] = def->run(new_ctx, eval);
+                return body->run(new_ctx, eval);
+            }
+            auto def_res = def->run(ctx, eval);
+            auto new_ctx = ctx.pushFrame(scope);
+            new_ctx.frame->slot_list[0] = std::move(def_res);
+            return body->run(new_ctx, eval);
+        }
+    };
+
+    // A position in the matched value: -1 steps into the body of a VInd, and i >= 0 steps into the i-th tuple field.
+    typedef std::vector<int> MatchPath;
+
+    const Data* _getByPath(const Data* value, const MatchPath& path) {
+        // Each step is guarded by a test on the way, so the casts always succeed.
+        for (auto step: path) {
+            if (step == -1) value = &static_cast<VInd*>(value->get())->body;
+            else value = &static_cast<VTuple*>(value->get())->elements[step];
+        }
+        return value;
+    }
+
+    enum class MatchNodeType {
+        FAIL, LEAF, SWITCH, TUPLE
+    };
+
+    // A node in the decision tree of a match expression.
+    struct MatchNode {
+        MatchNodeType type;
+        MatchPath path;
+        // For LEAF: the case taken, and the slots bound from paths.
+        int case_id = -1;
+        std::vector<std::pair<int, MatchPath>> binding_list;
+        // For SWITCH: a branch per constructor. For TUPLE: the tuple size.
+        std::vector<std::pair<int, std::unique_ptr<MatchNode>>> branch_list;
+        int size = 0;
+        // The branch of a successful tuple test.
+        std::unique_ptr<MatchNode> success;
+        // The branch taken when no test succeeds.
+        std::unique_ptr<MatchNode> fail;
+        MatchNode(MatchNodeType _type, const MatchPath& _path = {}): type(_type), path(_path) {}
+    };
+
+    struct MatchRow {
+        std::vector<PatternData*> cell_list; // nullptr stands for a wildcard.
+        int case_id;
+        std::vector<std::pair<int, MatchPath>> binding_list;
+    };
+
+    class _MatchTreeBuilder {
+    public:
+        // The slot of each variable in its case, in the order of getVarsInPattern.
+        std::unordered_map<PtVar*, int> slot_map;
+
+        void collectSlots(PatternData* pattern, int& pos) {
+            switch (pattern->getType()) {
+                case PatternType::UNDERSCORE: return;
+                case PatternType::VAR: {
+                    auto* pv = dynamic_cast<PtVar*>(pattern);
+                    slot_map[pv] = pos++;
+                    if (pv->body) collectSlots(pv->body.get(), pos);
+                    return;
+                }
+                case PatternType::TUPLE: {
+                    for (auto& field: dynamic_cast<PtTuple*>(pattern)->fields) collectSlots(field.get(), pos);
+                    return;
+                }
+                case PatternType::CONS: {
+                    collectSlots(dynamic_cast<PtCons*>(pattern)->body.get(), pos);
+                    return;
+                }
+            }
+        }
+
+        // Record the bindings of variables and leave only the tests in each cell.
+        void normalize(MatchRow& row, const std::vector<MatchPath>& column_list) {
+            for (int i = 0; i < row.cell_list.size(); ++i) {
+                auto*& cell = row.cell_list[i];
+                while (cell && cell->getType() != PatternType::TUPLE && cell->getType() != PatternType::CONS) {
+                    if (cell->getType() == PatternType::UNDERSCORE) {
+                        cell = nullptr; break;
+                    }
+                    auto* pv = dynamic_cast<PtVar*>(cell);
+                    row.binding_list.emplace_back(slot_map[pv], column_list[i]);
+                    cell = pv->body.get();
+                }
+            }
+        }
+
+        std::unique_ptr<MatchNode> build(std::vector<MatchRow> row_list, const std::vector<MatchPath>& column_list) {
+            if (row_list.empty()) return std::make_unique<MatchNode>(MatchNodeType::FAIL);
+            for (auto& row: row_list) normalize(row, column_list);
+            auto& first = row_list[0]; int column = -1;
+            for (int i = 0; i < first.cell_list.size(); ++i) {
+                if (first.cell_list[i]) {
+                    column = i; break;
+                }
+            }
+            if (column == -1) {
+                auto leaf = std::make_unique<MatchNode>(MatchNodeType::LEAF);
+                leaf->case_id = first.case_id; leaf->binding_list = first.binding_list;
+                return leaf;
+            }
+            auto& path = column_list[column];
+            // The sub-columns replacing the tested column in a successful branch.
+            auto expand = [&](const std::vector<MatchPath>& sub_path_list, const std::vector<std::vector<PatternData*>>& sub_cell_list,
+                    const std::vector<int>& row_id_list) {
+                std::vector<MatchPath> new_column_list;
+                for (int i = 0; i < column_list.size(); ++i) if (i != column) new_column_list.push_back(column_list[i]);
+                for (auto& sub_path: sub_path_list) new_column_list.push_back(sub_path);
+                std::vector<MatchRow> new_row_list;
+                for (int k = 0; k < row_id_list.size(); ++k) {
+                    auto& row = row_list[row_id_list[k]];
+                    MatchRow new_row{{}, row.case_id, row.binding_list};
+                    for (int i = 0; i < row.cell_list.size(); ++i) if (i != column) new_row.cell_list.push_back(row.cell_list[i]);
+                    for (auto* cell: sub_cell_list[k]) new_row.cell_list.push_back(cell);
+                    new_row_list.push_back(new_row);
+                }
+                return build(new_row_list, new_column_list);
+            };
+            auto* pattern = first.cell_list[column];
+            std::unique_ptr<MatchNode> node;
+            // Rows left for the branch where all tests fail.
+            std::vector<MatchRow> fail_list;
+            if (pattern->getType() == PatternType::TUPLE) {
+                int size = dynamic_cast<PtTuple*>(pattern)->fields.size();
+                node = std::make_unique<MatchNode>(MatchNodeType::TUPLE, path); node->size = size;
+                std::vector<MatchPath> sub_path_list;
+                for (int i = 0; i < size; ++i) {
+                    sub_path_list.push_back(path); sub_path_list.rbegin()->push_back(i);
+                }
+                std::vector<std::vector<PatternData*>> sub_cell_list; std::vector<int> row_id_list;
+                for (int i = 0; i < row_list.size(); ++i) {
+                    auto* cell = row_list[i].cell_list[column];
+                    auto* pt = dynamic_cast<PtTuple*>(cell);
+                    if (!cell) sub_cell_list.emplace_back(size, nullptr);
+                    else if (pt && pt->fields.size() == size) {
+                        sub_cell_list.emplace_back();
+                        for (auto& field: pt->fields) sub_cell_list.rbegin()->push_back(field.get());
+                    } else {
+                        fail_list.push_back(row_list[i]); continue;
+                    }
+                    row_id_list.push_back(i);
+                    if (!cell) fail_list.push_back(row_list[i]);
+                }
+                node->success = expand(sub_path_list, sub_cell_list, row_id_list);
+            } else {
+                node = std::make_unique<MatchNode>(MatchNodeType::SWITCH, path);
+                std::vector<int> tag_list;
+                for (auto& row: row_list) {
+                    auto* pc = dynamic_cast<PtCons*>(row.cell_list[column]);
+                    if (pc && std::find(tag_list.begin(), tag_list.end(), pc->tag) == tag_list.end()) tag_list.push_back(pc->tag);
+                }
+                auto sub_path = path; sub_path.push_back(-1);
+                for (auto tag: tag_list) {
+                    std::vector<std::vector<PatternData*>> sub_cell_list; std::vector<int> row_id_list;
+                    for (int i = 0; i < row_list.size(); ++i) {
+                        auto* cell = row_list[i].cell_list[column];
+                        auto* pc = dynamic_cast<PtCons*>(cell);
+                        if (!cell) sub_cell_list.push_back({nullptr});
+                        else if (pc && pc->tag == tag) sub_cell_list.push_back({pc->body.get()});
+                        else continue;
+                        row_id_list.push_back(i);
+                    }
+                    node->branch_list.emplace_back(tag, expand({sub_path}, sub_cell_list, row_id_list));
+                }
+                for (auto& row: row_list) {
+                    if (!dynamic_cast<PtCons*>(row.cell_list[column])) fail_list.push_back(row);
+                }
+            }
+            node->fail = build(fail_list, column_list);
+            return node;
+        }
+
+        std::unique_ptr<MatchNode> build(const MatchCaseList& case_list) {
+            std::vector<MatchRow> row_list;
+            for (int i = 0; i < case_list.size(); ++i) {
+                int pos = 0; collectSlots(case_list[i].first.get(), pos);
+                row_list.push_back({{case_list[i].first.get()}, i, {}});
+            }
+            return build(row_list, {{}});
+        }
+    };
+
+    // A match expression compiled into a decision tree, where each value is tested at most once on a path.
+    class CMatch: public CompiledTermData {
+    public:
+        TmMatch* term;
+        CompiledTerm def;
+        std::vector<std::pair<const VarScope*, CompiledTerm>> case_list; // The scope is nullptr if no variable is bound.
+        std::unique_ptr<MatchNode> root;
+        CMatch(TmMatch* _term, const CompiledTerm& _def, const std::vector<std::pair<const VarScope*, CompiledTerm>>& _case_list):
+            term(_term), def(_def), case_list(_case_list), root(_MatchTreeBuilder().build(_term->cases)) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto def_res = def->run(ctx, eval);
+            auto* node = root.get();
+            while (node->type != MatchNodeType::LEAF) {
+                switch (node->type) {
+                    case MatchNodeType::FAIL: {
+                        throw IncreSemanticsError("cannot match " + def_res.toString() + " with " + term->toString());
+                    }
+                    case MatchNodeType::TUPLE: {
+                        auto* vt = dynamic_cast<VTuple*>(_getByPath(&def_res, node->path)->get());
+                        node = (vt && vt->elements.size() == node->size) ? node->success.get() : node->fail.get();
+                        break;
+                    }
+                    case MatchNodeType::SWITCH: {
+                        auto* vi = dynamic_cast<VInd*>(_getByPath(&def_res, node->path)->get());
+                        auto* next = node->fail.get();
+                        if (vi) {
+                            for (auto& [tag, branch]: node->branch_list) {
+                                if (tag == vi->tag) {
+                                    next = branch.get(); break;
+                                }
+                            }
+                        }
+                        node = next;
+                        break;
+                    }
+                    case MatchNodeType::LEAF: break;
+                }
+            }
+            auto& [scope, body] = case_list[node->case_id];
+            if (!scope) return body->run(ctx, eval);
+            auto new_ctx = ctx.pushFrame(scope);
+            for (auto& [slot, path]: node->binding_list) new_ctx.frame->slot_list[slot] = *_getByPath(&def_res, path);
+            return body->run(new_ctx, eval);
+        }
+    };
+
+    class CTuple: public CompiledTermData {
+    public:
+        std::vector<CompiledTerm> field_list;
+        CTuple(const std::vector<CompiledTerm>& _field_list): field_list(_field_list) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            DataList elements(field_list.size());
+            for (int i = 0; i < field_list.size(); ++i) elements[i] = field_list[i]->run(ctx, eval);
+            return BuildData(Product, elements);
+        }
+    };
+
+    class CProj: public CompiledTermData {
+    public:
+        int id, size;
+        CompiledTerm body;
+        CProj(int _id, int _size, const CompiledTerm& _body): id(_id), size(_size), body(_body) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto res = body->run(ctx, eval);
+            auto* vt = dynamic_cast<VTuple*>(res.get());
+            if (!vt) throw IncreSemanticsError("the evaluation result of TmProj body should be a tuple, but got " + res.toString());
+            if (vt->elements.size() != size || vt->elements.size() < id) {
+                throw IncreSemanticsError("Incorrect tuple size, expected a type of size " + std::to_string(size) + ", but got " + res.toString());
+            }
+            return vt->elements[id - 1];
+        }
+    };
+
+    class CCons: public CompiledTermData {
+    public:
+        int cons_tag;
+        CompiledTerm body;
+        CCons(int _cons_tag, const CompiledTerm& _body): cons_tag(_cons_tag), body(_body) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            return data::makeData<VInd>(cons_tag, body->run(ctx, eval));
+        }
+    };
+
+    class CLabel: public CompiledTermData {
+    public:
+        CompiledTerm body;
+        CLabel(const CompiledTerm& _body): body(_body) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            return data::makeData<VCompress>(body->run(ctx, eval));
+        }
+    };
+
+    class CUnlabel: public CompiledTermData {
+    public:
+        CompiledTerm body;
+        CUnlabel(const CompiledTerm& _body): body(_body) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            auto res = body->run(ctx, eval);
+            auto* vc = dynamic_cast<VCompress*>(res.get());
+            if (!vc) throw IncreSemanticsError("the body of TmUnlabel should be a compress value, but got " + res.toString());
+            return vc->body;
+        }
+    };
+
+    class CHook: public CompiledTermData {
+    public:
+        TermData* term;
+        std::vector<std::pair<TermData*, CompiledTerm>> sub_list;
+        CHook(TermData* _term, const std::vector<std::pair<TermData*, CompiledTerm>>& _sub_list): term(_term), sub_list(_sub_list) {}
+        virtual Data run(const IncreContext& ctx, IncreCompiledEvaluator* eval) {
+            return eval->runHook(term, sub_list, ctx);
+        }
+    };
+
+    class _TermCompiler {
+    public:
+        int hook_mask;
+        _TermCompiler(int _hook_mask): hook_mask(_hook_mask) {}
+
+        std::vector<CompiledTerm> compileList(const TermList& term_list) {
+            std::vector<CompiledTerm> res;
+            for (auto& term: term_list) res.push_back(compile(term.get()));
+            return res;
+        }
+
+        CompiledTerm compile(TermData* term) {
+            if (hook_mask >> int(term->getType()) & 1) {
+                std::vector<std::pair<TermData*, CompiledTerm>> sub_list;
+                for (auto& sub_term: getSubTerms(term)) sub_list.emplace_back(sub_term.get(), compile(sub_term.get()));
+                return std::make_shared<CHook>(term, sub_list);
+            }
+            switch (term->getType()) {
+                case TermType::VALUE: return std::make_shared<CValue>(dynamic_cast<TmValue*>(term)->v);
+                case TermType::VAR: {
+                    auto* tv = dynamic_cast<TmVar*>(term);
+                    if (tv->depth >= 0) return std::make_shared<CLocalVar>(tv);
+                    if (tv->slot >= 0) return std::make_shared<CGlobalVar>(tv);
+                    return std::make_shared<CNamedVar>(tv);
+                }
+                case TermType::PRIMARY: {
+                    auto* tp = dynamic_cast<TmPrimary*>(term);
+                    auto param_list = compileList(tp->params);
+                    auto it = KBinaryOperatorMap.find(tp->op_name);
+                    if (it != KBinaryOperatorMap.end() && param_list.size() == 2) {
+                        return std::make_shared<CBinaryPrimary>(it->second, param_list[0], param_list[1]);
+                    }
+                    return std::make_shared<CPrimary>(tp->op_name, param_list);
+                }
+                case TermType::IF: {
+                    auto* ti = dynamic_cast<TmIf*>(term);
+                    return std::make_shared<CIf>(compile(ti->c.get()), compile(ti->t.get()), compile(ti->f.get()));
+                }
+                case TermType::APP: {
+                    auto* ta = dynamic_cast<TmApp*>(term);
+                    return std::make_shared<CApp>(compile(ta->func.get()), compile(ta->param.get()));
+                }
+                case TermType::FUNC: {
+                    auto* tf = dynamic_cast<TmFunc*>(term);
+                    return std::make_shared<CFunc>(tf, compile(tf->body.get()));
+                }
+                case TermType::LET: {
+                    auto* tl = dynamic_cast<TmLet*>(term);
+                    return std::make_shared<CLet>(tl->is_rec, getFrameScope(tl), compile(tl->def.get()), compile(tl->body.get()));
+                }
+                case TermType::MATCH: {
+                    auto* tm = dynamic_cast<TmMatch*>(term);
+                    std::vector<std::pair<const VarScope*, CompiledTerm>> case_list;
+                    for (int i = 0; i < tm->cases.size(); ++i) {
+                        auto* scope = getFrameScope(tm, i);
+                        if (scope->empty()) scope = nullptr;
+                        case_list.emplace_back(scope, compile(tm->cases[i].second.get()));
+                    }
+                    return std::make_shared<CMatch>(tm, compile(tm->def.get()), case_list);
+                }
+                case TermType::TUPLE: {
+                    return std::make_shared<CTuple>(compileList(dynamic_cast<TmTuple*>(term)->fields));
+                }
+                case TermType::PROJ: {
+                    auto* tp = dynamic_cast<TmProj*>(term);
+                    return std::make_shared<CProj>(tp->id, tp->size, compile(tp->body.get()));
+                }
+                case TermType::CONS: {
+                    auto* tc = dynamic_cast<TmCons*>(term);
+                    return std::make_shared<CCons>(tc->cons_tag, compile(tc->body.get()));
+                }
+                case TermType::LABEL: return std::make_shared<CLabel>(compile(dynamic_cast<TmLabel*>(term)->body.get()));
+                case TermType::UNLABEL: return std::make_shared<CUnlabel>(compile(dynamic_cast<TmUnlabel*>(term)->body.get()));
+                case TermType::REWRITE: return compile(dynamic_cast<TmRewrite*>(term)->body.get());
+            }
+            LOG(FATAL) << "Unknown term " << term->toString();
+        }
+    };
+}
+
+IncreCompiledEvaluator::IncreCompiledEvaluator(const std::vector<syntax::TermType> &hooked_types): hook_mask(0) {
+    for (auto type: hooked_types) hook_mask |= 1 << int(type);
+}
+
+int IncreCompiledEvaluator::getHookMask() const {
+    return hook_mask;
+}
+
+CompiledTerm IncreCompiledEvaluator::compile(syntax::TermData *term) {
+    return _TermCompiler(hook_mask).compile(term);
+}
+
+Data IncreCompiledEvaluator::evaluate(syntax::TermData *term, const IncreContext &ctx) {
+    // Sub-terms of the running hooks are compiled already.
+    for (auto it = hook_children.rbegin(); it != hook_children.rend(); ++it) {
+        if (it->first == term) return it->second->run(ctx, this);
+    }
+    return getCompiled(term)->run(ctx, this);
+}
+
+CompiledTerm IncreCompiledEvaluator::getCompiled(syntax::TermData *term) {
+    auto it = term_cache.find(term);
+    if (it != term_cache.end() && !it->second.first.expired()) return it->second.second;
+    auto compiled_term = compile(term);
+    std::weak_ptr<TermData> owner = term->weak_from_this();
+    // Terms not owned by shared pointers cannot be told apart from later terms at the same address.
+    if (owner.expired()) return compiled_term;
+    // Entries of released terms are dropped whenever the cache doubles, so short-lived terms do not accumulate.
+    if (term_cache.size() >= term_cache_limit) {
+        for (auto jt = term_cache.begin(); jt != term_cache.end();) {
+            if (jt->second.first.expired()) jt = term_cache.erase(jt); else ++jt;
+        }
+        term_cache_limit = std::max(term_cache_limit, term_cache.size() * 2);
+    }
+    term_cache[term] = {owner, compiled_term};
+    return compiled_term;
+}
+
+Data IncreCompiledEvaluator::interpret(syntax::TermData *term, const IncreContext &ctx) {
+    return IncreEvaluator::evaluate(term, ctx);
+}
+
+namespace {
+    class _HookGuard {
+    public:
+        std::vector<std::pair<TermData*, CompiledTermData*>>& hook_children;
+        int size;
+        _HookGuard(std::vector<std::pair<TermData*, CompiledTermData*>>& _hook_children):
+            hook_children(_hook_children), size(_hook_children.size()) {}
+        ~_HookGuard() {hook_children.resize(size);}
+    };
+}
+
+Data IncreCompiledEvaluator::runHook(syntax::TermData *term, const std::vector<std::pair<syntax::TermData *, CompiledTerm>> &sub_list,
+                                     const IncreContext &ctx) {
+    _HookGuard guard(hook_children);
+    for (auto& [sub_term, compiled_term]: sub_list) hook_children.emplace_back(sub_term, compiled_term.get());
+    return interpret(term, ctx);
+}
+
+CompiledTermData *IncreCompiledEvaluator::getBody(VClosure *closure) {
+    auto it = body_cache.find(closure->body.get());
+    if (it != body_cache.end()) return it->second.second.get();
+    auto compiled_body = compile(closure->body.get());
+    body_cache[closure->body.get()] = {closure->body, compiled_body};
+    return compiled_body.get();
+}
+
+Data IncreCompiledEvaluator::apply(const Data &func, const Data &param) {
+    auto* vc = dynamic_cast<VClosure*>(func.get());
+    if (!vc) throw IncreSemanticsError("the evaluation result of TmApp func should be a closure, but got " + func.toString());
+    return applyOne(vc, param);
+}
+
+Data IncreCompiledEvaluator::runClosure(VClosure *vc, const Data &param) {
+    auto new_ctx = vc->context.pushFrame(vc->scope);
+    new_ctx.frame->slot_list[0] = param;
+    auto* cc = dynamic_cast<VCompiledClosure*>(vc);
+    if (cc && cc->hook_mask == hook_mask) return cc->compiled_body->run(new_ctx, this);
+    return getBody(vc)->run(new_ctx, this);
+}
+
+namespace {
+    void _collectReferences(TermData* term, bool& is_rewrite, std::unordered_set<std::string>& reference_set) {
+        switch (term->getType()) {
+            case TermType::REWRITE: is_rewrite = true; break;
+            case TermType::VAR: reference_set.insert(dynamic_cast<TmVar*>(term)->name); return;
+            default: break;
+        }
+        for (auto& sub_term: getSubTerms(term)) _collectReferences(sub_term.get(), is_rewrite, reference_set);
+    }
+}
+
+TermList incre::semantics::collectPureFunctionBodies(IncreProgramData *program) {
+    std::unordered_map<std::string, std::unordered_set<std::string>> reference_map;
+    std::unordered_set<std::string> impure_set;
+    std::vector<std::pair<std::string, TmFunc*>> func_list;
+    for (auto& command: program->commands) {
+        auto* cb = dynamic_cast<CommandBindTerm*>(command.get());
+        if (!cb) continue;
+        bool is_rewrite = false;
+        _collectReferences(cb->term.get(), is_rewrite, reference_map[cb->name]);
+        if (is_rewrite) impure_set.insert(cb->name);
+        if (auto* tf = dynamic_cast<TmFunc*>(cb->term.get())) func_list.emplace_back(cb->name, tf);
+    }
+    // Propagate the impurity along references until a fixpoint.
+    for (bool is_changed = true; is_changed;) {
+        is_changed = false;
+        for (auto& [name, reference_set]: reference_map) {
+            if (impure_set.count(name)) continue;
+            for (auto& reference: reference_set) {
+                if (impure_set.count(reference)) {
+                    impure_set.insert(name); is_changed = true; break;
+                }
+            }
+        }
+    }
+    TermList res;
+    for (auto& [name, tf]: func_list) {
+        if (!impure_set.count(name)) res.push_back(tf->body);
+    }
+    return res;
+}
+
+const std::string incre::semantics::KIsUseMemoName = "IncreSemantics@IsUseMemo";
+const std::string incre::semantics::KMemoCapacityName = "IncreSemantics@MemoCapacity";
@@ -3,15 +3,25 @@
 //
 #include "istool/incre/language/incre_context.h"
 #include "glog/logging.h"
+#include <map>
+#include <mutex>
+#include <set>
 
 using namespace incre;
 using namespace incre::syntax;
 
 EnvAddress::EnvAddress(const std::string &_name, const syntax::Binding &_bind,
                        const std::shared_ptr<EnvAddress> &_next):
-                       name(_name), bind(_bind), next(_next) {
+                       name(_name), bind(_bind), next(_next), index(_next ? _next->index + 1 : 0) {
+}
+IncreFrame::IncreFrame(const std::shared_ptr<IncreFrame> &_parent, const syntax::VarScope *_scope):
+    parent(_parent), scope(_scope), slot_list(_scope->size()) {
 }
 IncreContext::IncreContext(const std::shared_ptr<EnvAddress> &_start): start(_start) {}
+IncreContext::IncreContext(const std::shared_ptr<EnvAddress> &_start, const PIncreFrame &_frame,
+                           const std::shared_ptr<std::vector<EnvAddress *>> &_global_list):
+                           start(_start), frame(_frame), global_list(_global_list) {
+}
 
 syntax::Ty IncreContext::getRawType(const std::string &name) const {
     for (auto now = start; now; now = now->next) {
@@ -25,12 +35,49 @@ syntax::Ty IncreContext::getFinalType(const std::string &_name, syntax::IncreTyp
 }
 
 Data IncreContext::getData(const std::string &name) const {
+    for (auto* now = frame.get(); now; now = now->parent.get()) {
+        auto& names = *now->scope;
+        for (int i = int(names.size()) - 1; i >= 0; --i) {
+            if (names[i] == name) {
+                if (now->slot_list[i].isNull()) LOG(FATAL) << "No data is bound to " << name;
+                return now->slot_list[i];
+            }
+        }
+    }
     for (auto now = start; now; now = now->next) {
         if (now->name == name) return now->bind.getData();
     }
     LOG(FATAL) << "No data is bound to " << name;
 }
 
+EnvAddress *IncreContext::getGlobal(int index) const {
+    // global_list may be shared with contexts extending this one, and thus it can be longer than the bindings.
+    if (!global_list || index < 0 || !start || index > start->index) return nullptr;
+    return (*global_list)[index];
+}
+
+Data IncreContext::getData(syntax::TmVar *var) const {
+    if (var->depth >= 0) {
+        auto* now = frame.get();
+        for (int i = 0; now && i < var->depth; ++i) now = now->parent.get();
+        if (now && now->scope == var->scope) return now->slot_list[var->slot];
+    } else if (auto* address = getGlobal(var->slot)) {
+        if (address->name == var->name) return address->bind.data;
+    }
+    // Fall back to the lookup by name, which happens when var is not resolved or is evaluated in a context of a
+    // different shape. var is never modified here, since terms may be evaluated by several threads.
+    for (auto* now = frame.get(); now; now = now->parent.get()) {
+        auto& names = *now->scope;
+        for (int i = int(names.size()) - 1; i >= 0; --i) {
+            if (names[i] == var->name) return now->slot_list[i];
+        }
+    }
+    for (auto now = start; now; now = now->next) {
+        if (now->name == var->name) return now->bind.data;
+    }
+    return {};
+}
+
 #include <iostream>
 void IncreContext::printTypes() const {
     std::vector<std::pair<std::string, Ty>> info_list;
@@ -70,12 +117,27 @@ bool IncreContext::isContain(const std::string &name) {
 }
 
 IncreContext IncreContext::insert(const std::string &name, const syntax::Binding &binding) const {
-    return std::make_shared<EnvAddress>(name, binding, start);
+    auto address = std::make_shared<EnvAddress>(name, binding, start);
+    if (!global_list) return {address, frame, nullptr};
+    // The prefix is always copied, since the index of start may be shared with contexts extended by other threads.
+    auto index = std::make_shared<std::vector<EnvAddress*>>(global_list->begin(), global_list->begin() + address->index);
+    index->push_back(address.get());
+    return {address, frame, index};
+}
+
+IncreContext IncreContext::pushFrame(const syntax::VarScope *scope) const {
+    return {start, std::make_shared<IncreFrame>(frame, scope), global_list};
+}
+
+IncreContext IncreContext::indexGlobals() const {
+    auto index = std::make_shared<std::vector<EnvAddress*>>(start ? start->index + 1 : 0);
+    for (auto now = start; now; now = now->next) (*index)[now->index] = now.get();
+    return {start, frame, index};
 }
 
 IncreFullContextData::IncreFullContextData(const IncreContext &_ctx,
                                            const std::unordered_map<std::string, EnvAddress *> &_address_map):
-                                           ctx(_ctx), address_map(_address_map) {
+                                           ctx(_ctx.global_list ? _ctx : _ctx.indexGlobals()), address_map(_address_map) {
 }
 
 void IncreFullContextData::setGlobalInput(const std::unordered_map<std::string, Data> &global_input) {
@@ -87,4 +149,17 @@ void IncreFullContextData::setGlobalInput(const std::unordered_map<std::string,
         if (it == address_map.end()) LOG(FATAL) << "Unknown global input " << name;
         it->second->bind.data = value;
     }
-}
\ No newline at end of file
+}
+
+const syntax::VarScope *incre::internScope(const syntax::VarScope &scope) {
+    static std::set<syntax::VarScope> scope_pool;
+    static std::mutex scope_lock;
+    // Each thread caches the interned scopes it has met, such that the shared pool is locked only on the first use.
+    thread_local std::map<syntax::VarScope, const syntax::VarScope*> local_cache;
+    auto it = local_cache.find(scope);
+    if (it != local_cache.end()) return it->second;
+    std::lock_guard<std::mutex> guard(scope_lock);
+    auto* res = &*scope_pool.insert(scope).first;
+    local_cache[scope] = res;
+    return res;
+}
@@ -0,0 +1,247 @@
+//
+// Created by pro on 2024/3/14.
+//
+
+#include "istool/incre/language/incre_iterative_semantics.h"
+#include "glog/logging.h"
+
+using namespace incre;
+using namespace incre::semantics;
+using namespace incre::syntax;
+
+typedef IncreIterativeEvaluator::ContinuationType ContinuationType;
+
+IncreIterativeEvaluator::IncreIterativeEvaluator(const std::vector<syntax::TermType> &hooked_types): hook_mask(0) {
+    for (auto type: hooked_types) hook_mask |= 1 << int(type);
+}
+
+#define HookCase(name) \
+  case TermType:: TERM_TOKEN_ ## name: return _evaluate(dynamic_cast<Tm ## name*>(term), ctx);
+
+Data IncreIterativeEvaluator::buildCompress(syntax::TmLabel *term, const Data &body) {
+    return data::makeData<VCompress>(body);
+}
+
+Data IncreIterativeEvaluator::finishRewrite(syntax::TmRewrite *term, const IncreContext &ctx, const Data &res) {
+    return res;
+}
+
+Data IncreIterativeEvaluator::runHook(syntax::TermData *term, const IncreContext &ctx) {
+    switch (term->getType()) {
+        TERM_CASE_ANALYSIS(HookCase);
+    }
+    LOG(FATAL) << "Unknown term " << term->toString();
+}
+
+namespace {
+    // Restore the stacks when a run exits, including exits by exceptions.
+    class _StackGuard {
+    public:
+        std::vector<IncreIterativeEvaluator::Continuation>& continuation_stack;
+        DataList& value_stack;
+        int continuation_size, value_size;
+        _StackGuard(std::vector<IncreIterativeEvaluator::Continuation>& _continuation_stack, DataList& _value_stack):
+            continuation_stack(_continuation_stack), value_stack(_value_stack),
+            continuation_size(_continuation_stack.size()), value_size(_value_stack.size()) {}
+        ~_StackGuard() {
+            continuation_stack.erase(continuation_stack.begin() + continuation_size, continuation_stack.end());
+            value_stack.resize(value_size);
+        }
+    };
+
+    DataList _popValues(DataList& value_stack, int num) {
+        DataList res(std::make_move_iterator(value_stack.end() - num), std::make_move_iterator(value_stack.end()));
+        value_stack.resize(value_stack.size() - num);
+        return res;
+    }
+}
+
+Data IncreIterativeEvaluator::evaluate(syntax::TermData *term, const IncreContext &ctx) {
+    _StackGuard guard(continuation_stack, value_stack);
+    int base = continuation_stack.size();
+    auto* now = term; auto now_ctx = ctx;
+    Data value; bool is_value = false;
+    while (true) {
+        if (!is_value) {
+            is_value = true;
+            if (hook_mask >> int(now->getType()) & 1) {
+                value = runHook(now, now_ctx); continue;
+            }
+            switch (now->getType()) {
+                case TermType::VALUE: {
+                    value = dynamic_cast<TmValue*>(now)->v; break;
+                }
+                case TermType::VAR: {
+                    auto* tv = dynamic_cast<TmVar*>(now);
+                    value = now_ctx.getData(tv);
+                    if (value.isNull()) value = _evaluate(tv, now_ctx);
+                    break;
+                }
+                case TermType::FUNC: {
+                    auto* tf = dynamic_cast<TmFunc*>(now);
+                    value = data::makeData<VClosure>(now_ctx, tf->name, tf->body, getFrameScope(tf)); break;
+                }
+                case TermType::IF: {
+                    continuation_stack.push_back({ContinuationType::IF, now, now_ctx, 0});
+                    now = dynamic_cast<TmIf*>(now)->c.get(); is_value = false; break;
+                }
+                case TermType::APP: {
+                    continuation_stack.push_back({ContinuationType::APP_PARAM, now, now_ctx, 0});
+                    now = dynamic_cast<TmApp*>(now)->func.get(); is_value = false; break;
+                }
+                case TermType::LET: {
+                    auto* tl = dynamic_cast<TmLet*>(now);
+                    if (tl->is_rec) now_ctx = now_ctx.pushFrame(getFrameScope(tl));
+                    continuation_stack.push_back({ContinuationType::LET, now, now_ctx, 0});
+                    now = tl->def.get(); is_value = false; break;
+                }
+                case TermType::MATCH: {
+                    continuation_stack.push_back({ContinuationType::MATCH, now, now_ctx, 0});
+                    now = dynamic_cast<TmMatch*>(now)->def.get(); is_value = false; break;
+                }
+                case TermType::TUPLE: {
+                    auto* tt = dynamic_cast<TmTuple*>(now);
+                    if (tt->fields.empty()) {
+                        value = BuildData(Product, DataList()); break;
+                    }
+                    continuation_stack.push_back({ContinuationType::TUPLE, now, now_ctx, 0});
+                    now = tt->fields[0].get(); is_value = false; break;
+                }
+                case TermType::PRIMARY: {
+                    auto* tp = dynamic_cast<TmPrimary*>(now);
+                    if (tp->params.empty()) {
+                        value = invokePrimary(tp->op_name, {}); break;
+                    }
+                    continuation_stack.push_back({ContinuationType::PRIMARY, now, now_ctx, 0});
+                    now = tp->params[0].get(); is_value = false; break;
+                }
+                case TermType::PROJ: {
+                    continuation_stack.push_back({ContinuationType::PROJ, now, now_ctx, 0});
+                    now = dynamic_cast<TmProj*>(now)->body.get(); is_value = false; break;
+                }
+                case TermType::CONS: {
+                    continuation_stack.push_back({ContinuationType::CONS, now, now_ctx, 0});
+                    now = dynamic_cast<TmCons*>(now)->body.get(); is_value = false; break;
+                }
+                case TermType::LABEL: {
+                    continuation_stack.push_back({ContinuationType::LABEL, now, now_ctx, 0});
+                    now = dynamic_cast<TmLabel*>(now)->body.get(); is_value = false; break;
+                }
+                case TermType::UNLABEL: {
+                    continuation_stack.push_back({ContinuationType::UNLABEL, now, now_ctx, 0});
+                    now = dynamic_cast<TmUnlabel*>(now)->body.get(); is_value = false; break;
+                }
+                case TermType::REWRITE: {
+                    continuation_stack.push_back({ContinuationType::REWRITE, now, now_ctx, 0});
+                    now = dynamic_cast<TmRewrite*>(now)->body.get(); is_value = false; break;
+                }
+            }
+            continue;
+        }
+        if (continuation_stack.size() == base) return value;
+        auto current = std::move(continuation_stack.back()); continuation_stack.pop_back();
+        switch (current.type) {
+            case ContinuationType::IF: {
+                auto* ti = dynamic_cast<TmIf*>(current.term);
+                now = value.isTrue() ? ti->t.get() : ti->f.get();
+                now_ctx = std::move(current.ctx); is_value = false; break;
+            }
+            case ContinuationType::APP_PARAM: {
+                value_stack.push_back(std::move(value));
+                now = dynamic_cast<TmApp*>(current.term)->param.get(); now_ctx = std::move(current.ctx);
+                current.type = ContinuationType::APP_CALL;
+                continuation_stack.push_back(std::move(current));
+                is_value = false; break;
+            }
+            case ContinuationType::APP_CALL: {
+                auto func = std::move(value_stack.back()); value_stack.pop_back();
+                auto* vc = dynamic_cast<VClosure*>(func.get());
+                if (!vc) throw IncreSemanticsError("the evaluation result of TmApp func should be a closure, but got " + func.toString());
+                consumeFuel();
+                int index = getMemoIndex(vc, value);
+                if (index >= 0) {
+                    Data res;
+                    if (lookupMemo(index, vc->body.get(), value, res)) {
+                        value = std::move(res); break;
+                    }
+                    value_stack.push_back(value);
+                    continuation_stack.push_back({ContinuationType::MEMO, vc->body.get(), IncreContext(nullptr), index});
+                }
+                // Unless memoized, the call is in a tail position of the machine, so no continuation is left for it.
+                now_ctx = vc->context.pushFrame(vc->scope);
+                now_ctx.frame->slot_list[0] = std::move(value);
+                now = vc->body.get(); is_value = false; break;
+            }
+            case ContinuationType::LET: {
+                auto* tl = dynamic_cast<TmLet*>(current.term);
+                if (tl->is_rec) now_ctx = std::move(current.ctx);
+                else now_ctx = current.ctx.pushFrame(getFrameScope(tl));
+                now_ctx.frame->slot_list[0] = std::move(value);
+                now = tl->body.get(); is_value = false; break;
+            }
+            case ContinuationType::MATCH: {
+                auto* tm = dynamic_cast<TmMatch*>(current.term);
+                int id = 0;
+                while (id < tm->cases.size() && !isValueMatchPattern(tm->cases[id].first.get(), value)) ++id;
+                if (id == tm->cases.size()) throw IncreSemanticsError("cannot match " + value.toString() + " with " + tm->toString());
+                auto* scope = getFrameScope(tm, id);
+                if (scope->empty()) now_ctx = std::move(current.ctx);
+                else {
+                    now_ctx = current.ctx.pushFrame(scope);
+                    auto* pos = now_ctx.frame->slot_list.data();
+                    bindValueToSlots(tm->cases[id].first.get(), value, pos);
+                }
+                now = tm->cases[id].second.get(); is_value = false; break;
+            }
+            case ContinuationType::TUPLE: {
+                auto* tt = dynamic_cast<TmTuple*>(current.term);
+                value_stack.push_back(std::move(value));
+                if (++current.index < tt->fields.size()) {
+                    now = tt->fields[current.index].get(); now_ctx = current.ctx; is_value = false;
+                    continuation_stack.push_back(std::move(current));
+                } else value = BuildData(Product, _popValues(value_stack, current.index));
+                break;
+            }
+            case ContinuationType::PRIMARY: {
+                auto* tp = dynamic_cast<TmPrimary*>(current.term);
+                value_stack.push_back(std::move(value));
+                if (++current.index < tp->params.size()) {
+                    now = tp->params[current.index].get(); now_ctx = current.ctx; is_value = false;
+                    continuation_stack.push_back(std::move(current));
+                } else value = invokePrimary(tp->op_name, _popValues(value_stack, current.index));
+                break;
+            }
+            case ContinuationType::PROJ: {
+                auto* tp = dynamic_cast<TmProj*>(current.term);
+                auto* vt = dynamic_cast<VTuple*>(value.get());
+                if (!vt) throw IncreSemanticsError("the evaluation result of TmProj body should be a tuple, but got " + value.toString());
+                if (vt->elements.size() != tp->size || vt->elements.size() < tp->id) {
+                    throw IncreSemanticsError("Incorrect tuple size, expected a type of size " + std::to_string(tp->size) + ", but got " + value.toString());
+                }
+                auto res = vt->elements[tp->id - 1];
+                value = std::move(res); break;
+            }
+            case ContinuationType::CONS: {
+                value = data::makeData<VInd>(dynamic_cast<TmCons*>(current.term)->cons_tag, value); break;
+            }
+            case ContinuationType::LABEL: {
+                value = buildCompress(dynamic_cast<TmLabel*>(current.term), value); break;
+            }
+            case ContinuationType::UNLABEL: {
+                auto* vc = dynamic_cast<VCompress*>(value.get());
+                if (!vc) throw IncreSemanticsError("the body of TmUnlabel should be a compress value, but got " + value.toString());
+                auto res = vc->body;
+                value = std::move(res); break;
+            }
+            case ContinuationType::REWRITE: {
+                value = finishRewrite(dynamic_cast<TmRewrite*>(current.term), current.ctx, value); break;
+            }
+            case ContinuationType::MEMO: {
+                auto param = std::move(value_stack.back()); value_stack.pop_back();
+                storeMemo(current.index, current.term, param, value); break;
+            }
+        }
+    }
+}
+
+const std::string incre::semantics::KIsUseIterativeName = "IncreSemantics@IsUseIterative";
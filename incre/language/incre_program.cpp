@@ -29,6 +29,7 @@ CommandBindTerm::CommandBindTerm(const std::string &_name, bool _is_func, const
 CommandDef::CommandDef(const std::string &_name, int _param, const std::vector<std::pair<std::string, Ty>> &_cons_list,
                        const DecorateSet &decos, const std::string& _source):
                        param(_param), cons_list(_cons_list), CommandData(CommandType::DEF_IND, _name, decos, _source) {
+    for (auto& [cons_name, _]: cons_list) syntax::getConsTag(cons_name);
 }
 
 CommandDeclare::CommandDeclare(const std::string &_name, const syntax::Ty &_type, const DecorateSet &decos, const std::string& _source):
@@ -69,9 +70,16 @@ void incre::IncreProgramWalker::walkThrough(IncreProgramData *program) {
     }
 }
 
+namespace {
+    // The type checker extends the context in many branches, where carrying the index of globals forward would copy it.
+    IncreContext _getTypingContext(const IncreContext& ctx) {
+        return IncreContext(ctx.start);
+    }
+}
+
 incre::DefaultContextBuilder::DefaultContextBuilder(incre::semantics::IncreEvaluator *_evaluator,
                                                     incre::types::IncreTypeChecker *_checker):
-                                                    evaluator(_evaluator), checker(_checker), ctx(nullptr) {
+                                                    evaluator(_evaluator), checker(_checker), ctx(IncreContext(nullptr).indexGlobals()) {
 }
 
 void incre::DefaultContextBuilder::visit(CommandBindTerm *command) {
@@ -81,9 +89,10 @@ void incre::DefaultContextBuilder::visit(CommandBindTerm *command) {
         if (!address->bind.data.isNull()) LOG(FATAL) << "Duplicated declaration on name " << command->name;
         if (checker) {
             assert(address->bind.type);
-            checker->unify(address->bind.type, checker->typing(command->term.get(), ctx));
+            checker->unify(address->bind.type, checker->typing(command->term.get(), _getTypingContext(ctx)));
         }
         if (evaluator) {
+            semantics::resolveTerm(command->term.get(), ctx);
             address->bind.data = evaluator->evaluate(command->term.get(), ctx);
         }
     } else if (command->is_rec) {
@@ -92,12 +101,13 @@ void incre::DefaultContextBuilder::visit(CommandBindTerm *command) {
         if (checker) {
             checker->pushLevel(); auto current_type = checker->getTmpVar(ANY);
             address->bind.type = current_type;
-            checker->unify(current_type, checker->typing(command->term.get(), ctx));
+            checker->unify(current_type, checker->typing(command->term.get(), _getTypingContext(ctx)));
             checker->popLevel();
             auto final_type = checker->generalize(current_type, command->term.get());
             address->bind.type = final_type;
         }
         if (evaluator) {
+            semantics::resolveTerm(command->term.get(), ctx);
             auto v = evaluator->evaluate(command->term.get(), ctx);
             address->bind.data = v;
         }
@@ -105,10 +115,14 @@ void incre::DefaultContextBuilder::visit(CommandBindTerm *command) {
         Ty type = nullptr;
         if (checker) {
             // LOG(INFO) << command->term->toString();
-            checker->pushLevel(); type = checker->typing(command->term.get(), ctx);
+            checker->pushLevel(); type = checker->typing(command->term.get(), _getTypingContext(ctx));
             checker->popLevel(); type = checker->generalize(type, command->term.get());
         }
-        auto res = evaluator ? evaluator->evaluate(command->term.get(), ctx): Data();
+        Data res;
+        if (evaluator) {
+            semantics::resolveTerm(command->term.get(), ctx);
+            res = evaluator->evaluate(command->term.get(), ctx);
+        }
         ctx = ctx.insert(command->name, Binding(false, type, res));
     }
 }
@@ -194,6 +208,7 @@ void ProgramRunner::postProcess(incre::CommandData *command) {
         case CommandType::EVAL: {
             auto* ce = dynamic_cast<CommandEval*>(command);
             ctx.printTypes();
+            semantics::resolveTerm(ce->term.get(), ctx);
             auto res_value = evaluator->evaluate(ce->term.get(), ctx);
             auto res_term = std::make_shared<TmValue>(res_value);
             auto new_command = std::make_shared<CommandEval>(ce->name, res_term, ce->decos, ce->source);
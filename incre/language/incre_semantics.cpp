@@ -13,16 +13,15 @@ IncreSemanticsError::IncreSemanticsError(const std::string _message): message(_m
 
 const char *IncreSemanticsError::what() const noexcept {return message.c_str();}
 
-std::string VUnit::toString() const {return "unit";}
-
-bool VUnit::equal(Value *value) const {
-    return dynamic_cast<VUnit*>(value);
-}
 VClosure::VClosure(const IncreContext &_context, const std::string &_name, const syntax::Term &_body):
-    context(_context), name(_name), body(_body) {
+    context(_context), name(_name), body(_body), scope(internScope({_name})) {
+}
+VClosure::VClosure(const IncreContext &_context, const std::string &_name, const syntax::Term &_body,
+                   const syntax::VarScope *_scope): context(_context), name(_name), body(_body), scope(_scope) {
 }
 VClosure::VClosure(const std::tuple<IncreContext, std::string, syntax::Term> &_content):
-    context(std::get<0>(_content)), name(std::get<1>(_content)), body(std::get<2>(_content)) {
+    context(std::get<0>(_content)), name(std::get<1>(_content)), body(std::get<2>(_content)),
+    scope(internScope({std::get<1>(_content)})) {
 }
 
 VCompress::VCompress(const Data &_body): body(_body) {}
@@ -31,6 +30,9 @@ bool VCompress::equal(Value *value) const {
     auto* vc = dynamic_cast<VCompress*>(value);
     return vc && body == vc->body;
 }
+size_t VCompress::hash() const {
+    return data::hashCombine(std::hash<std::string>()("compress"), body.hash());
+}
 std::string VCompress::toString() const {
     return "compress " + body.toString();
 }
@@ -43,18 +45,119 @@ bool VClosure::equal(Value *value) const {
     return false;
 }
 
-VInd::VInd(const std::string &_name, const Data &_body): name(_name), body(_body) {
+VInd::VInd(int _tag, const Data &_body): tag(_tag), body(_body), hash_cache(0) {
+}
+VInd::VInd(const std::string &_name, const Data &_body): tag(syntax::getConsTag(_name)), body(_body), hash_cache(0) {
+}
+VInd::VInd(const std::pair<std::string, Data> &_content): tag(syntax::getConsTag(_content.first)), body(_content.second), hash_cache(0) {
 }
-VInd::VInd(const std::pair<std::string, Data> &_content): name(_content.first), body(_content.second) {
+
+const std::string &VInd::getName() const {
+    return syntax::getConsName(tag);
+}
+
+namespace {
+    VInd* _getInd(const Data& data) {
+        return data.getKind() == DataKind::VALUE ? dynamic_cast<VInd*>(data.get()) : nullptr;
+    }
+    VTuple* _getTuple(const Data& data) {
+        return data.getKind() == DataKind::VALUE ? dynamic_cast<VTuple*>(data.get()) : nullptr;
+    }
+
+    // The bodies released by the outermost running ~VInd of this thread.
+    thread_local DataList* _pending_body_list = nullptr;
+
+    // Push the inductive values in data whose hashes are not cached, looking through tuples.
+    void _pushUncachedInd(const Data& data, std::vector<std::pair<const VInd*, bool>>& stack) {
+        if (auto* vi = _getInd(data)) {
+            if (!vi->hash_cache.load(std::memory_order_relaxed)) stack.emplace_back(vi, false);
+        } else if (auto* vt = _getTuple(data)) {
+            for (auto& element: vt->elements) _pushUncachedInd(element, stack);
+        }
+    }
+}
+
+VInd::~VInd() {
+    // The body is released by the outermost destructor of this thread, which takes over the bodies of the nested
+    // inductive values one by one instead of destroying them recursively.
+    if (body.getKind() != DataKind::VALUE) return;
+    if (_pending_body_list) {
+        _pending_body_list->push_back(std::move(body)); return;
+    }
+    DataList pending_body_list;
+    pending_body_list.push_back(std::move(body));
+    _pending_body_list = &pending_body_list;
+    while (!pending_body_list.empty()) {
+        auto released = std::move(pending_body_list.back());
+        pending_body_list.pop_back();
+    }
+    _pending_body_list = nullptr;
 }
 
 std::string VInd::toString() const {
-    return name + " " + body.toString();
+    // Each item is either a piece of the result or a value still to be printed.
+    std::vector<std::pair<std::string, const Data*>> stack = {{"", &body}, {getName() + " ", nullptr}};
+    std::string res;
+    while (!stack.empty()) {
+        auto [text, data] = std::move(stack.back()); stack.pop_back();
+        if (!data) {
+            res += text; continue;
+        }
+        if (auto* vi = _getInd(*data)) {
+            stack.emplace_back("", &vi->body); stack.emplace_back(vi->getName() + " ", nullptr);
+        } else if (auto* vt = _getTuple(*data)) {
+            for (int i = int(vt->elements.size()) - 1; i >= 0; --i) {
+                stack.emplace_back(")", nullptr); stack.emplace_back("", &vt->elements[i]);
+                stack.emplace_back(i ? " (" : "(", nullptr);
+            }
+        } else res += data->toString();
+    }
+    return res;
 }
 
 bool VInd::equal(Value *value) const {
     auto* vi = dynamic_cast<VInd*>(value);
-    return name == vi->name && body == vi->body;
+    if (!vi || tag != vi->tag) return false;
+    std::vector<std::pair<const Data*, const Data*>> stack = {{&body, &vi->body}};
+    while (!stack.empty()) {
+        auto [x, y] = stack.back(); stack.pop_back();
+        if (x->isIdentical(*y)) continue;
+        auto *xi = _getInd(*x), *yi = _getInd(*y);
+        if (xi && yi) {
+            auto x_hash = xi->hash_cache.load(std::memory_order_relaxed);
+            auto y_hash = yi->hash_cache.load(std::memory_order_relaxed);
+            if (xi->tag != yi->tag || (x_hash && y_hash && x_hash != y_hash)) return false;
+            stack.emplace_back(&xi->body, &yi->body); continue;
+        }
+        auto *xt = _getTuple(*x), *yt = _getTuple(*y);
+        if (xt && yt) {
+            if (xt->elements.size() != yt->elements.size()) return false;
+            for (int i = 0; i < xt->elements.size(); ++i) stack.emplace_back(&xt->elements[i], &yt->elements[i]);
+            continue;
+        }
+        if (!(*x == *y)) return false;
+    }
+    return true;
+}
+
+size_t VInd::hash() const {
+    // VInd is immutable, so the hash is cached and rehashing a value takes O(1) time. The uncached inductive values
+    // inside are hashed first in post-order, such that each hash computation below only reaches cached values.
+    auto res = hash_cache.load(std::memory_order_relaxed);
+    if (res) return res;
+    std::vector<std::pair<const VInd*, bool>> stack = {{this, false}};
+    while (!stack.empty()) {
+        auto& [now, is_expanded] = stack.back();
+        if (!is_expanded) {
+            is_expanded = true;
+            _pushUncachedInd(now->body, stack); continue;
+        }
+        auto now_hash = data::hashCombine(std::hash<int>()(now->tag), now->body.hash());
+        if (!now_hash) now_hash = 1;
+        now->hash_cache.store(now_hash, std::memory_order_relaxed);
+        stack.pop_back();
+    }
+    return hash_cache.load(std::memory_order_relaxed);
 }
 
 #define INT_BINARY(sop, op, oup) if (name == sop) return BuildData(oup, theory::clia::getIntValue(params[0]) op theory::clia::getIntValue(params[1]))
@@ -85,6 +188,163 @@ Data incre::semantics::IncreEvaluator::evaluate(syntax::TermData *term, const In
     return res;
 }
 
+const VarScope* incre::semantics::getFrameScope(TmFunc* term) {
+    return term->scope ? term->scope : internScope({term->name});
+}
+
+const VarScope* incre::semantics::getFrameScope(TmLet* term) {
+    return term->scope ? term->scope : internScope({term->name});
+}
+
+const VarScope* incre::semantics::getFrameScope(TmMatch* term, int case_id) {
+    if (term->scope_list.size() == term->cases.size()) return term->scope_list[case_id];
+    return internScope(getVarsInPattern(term->cases[case_id].first.get()));
+}
+
+namespace {
+    class _TermResolver {
+    public:
+        const IncreContext& ctx;
+        std::vector<const VarScope*> scope_stack;
+        _TermResolver(const IncreContext& _ctx): ctx(_ctx) {}
+
+        bool resolveInScope(TmVar* var, const VarScope* scope, int depth) {
+            for (int i = int(scope->size()) - 1; i >= 0; --i) {
+                if (scope->at(i) == var->name) {
+                    var->depth = depth; var->slot = i; var->scope = scope;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void resolveVar(TmVar* var) {
+            if (var->slot != -1) return;
+            int depth = 0;
+            for (int i = int(scope_stack.size()) - 1; i >= 0; --i, ++depth) {
+                if (resolveInScope(var, scope_stack[i], depth)) return;
+            }
+            for (auto* frame = ctx.frame.get(); frame; frame = frame->parent.get(), ++depth) {
+                if (resolveInScope(var, frame->scope, depth)) return;
+            }
+            for (auto now = ctx.start; now; now = now->next) {
+                if (now->name == var->name) {
+                    var->slot = now->index; return;
+                }
+            }
+        }
+
+        void resolveWithScope(TermData* term, const VarScope* scope) {
+            scope_stack.push_back(scope); resolve(term); scope_stack.pop_back();
+        }
+
+        void resolve(TermData* term) {
+            switch (term->getType()) {
+                case TermType::VAR: {
+                    resolveVar(dynamic_cast<TmVar*>(term)); return;
+                }
+                case TermType::FUNC: {
+                    auto* tf = dynamic_cast<TmFunc*>(term);
+                    tf->scope = getFrameScope(tf);
+                    resolveWithScope(tf->body.get(), tf->scope); return;
+                }
+                case TermType::LET: {
+                    auto* tl = dynamic_cast<TmLet*>(term);
+                    tl->scope = getFrameScope(tl);
+                    if (tl->is_rec) resolveWithScope(tl->def.get(), tl->scope); else resolve(tl->def.get());
+                    resolveWithScope(tl->body.get(), tl->scope); return;
+                }
+                case TermType::MATCH: {
+                    auto* tm = dynamic_cast<TmMatch*>(term);
+                    resolve(tm->def.get());
+                    std::vector<const VarScope*> scope_list;
+                    for (int i = 0; i < tm->cases.size(); ++i) scope_list.push_back(getFrameScope(tm, i));
+                    tm->scope_list = scope_list;
+                    for (int i = 0; i < tm->cases.size(); ++i) {
+                        // A case binding no variable does not introduce a frame.
+                        if (scope_list[i]->empty()) resolve(tm->cases[i].second.get());
+                        else resolveWithScope(tm->cases[i].second.get(), scope_list[i]);
+                    }
+                    return;
+                }
+                default: {
+                    for (auto& sub_term: getSubTerms(term)) resolve(sub_term.get());
+                }
+            }
+        }
+    };
+}
+
+void incre::semantics::resolveTerm(syntax::TermData *term, const IncreContext &ctx) {
+    _TermResolver(ctx).resolve(term);
+}
+
+void IncreEvaluator::consumeFuel() {
+    if (fuel > 0) --fuel;
+    else if (fuel == 0) throw IncreSemanticsError("the evaluation runs out of fuel");
+}
+
+Data IncreEvaluator::applyClosure(VClosure *closure, const DataList &params) {
+    Data res;
+    for (int i = 0; i < params.size(); ++i) {
+        if (i) {
+            closure = dynamic_cast<VClosure*>(res.get());
+            if (!closure) throw IncreSemanticsError("expected a closure when applying parameters, but got " + res.toString());
+        }
+        res = applyOne(closure, params[i]);
+    }
+    return res;
+}
+
+Data IncreEvaluator::applyOne(VClosure *closure, const Data &param) {
+    consumeFuel();
+    int index = getMemoIndex(closure, param);
+    if (index < 0) return runClosure(closure, param);
+    Data res;
+    if (lookupMemo(index, closure->body.get(), param, res)) return res;
+    res = runClosure(closure, param);
+    storeMemo(index, closure->body.get(), param, res);
+    return res;
+}
+
+Data IncreEvaluator::runClosure(VClosure *closure, const Data &param) {
+    auto new_ctx = closure->context.pushFrame(closure->scope);
+    new_ctx.frame->slot_list[0] = param;
+    return evaluate(closure->body.get(), new_ctx);
+}
+
+void IncreEvaluator::enableMemo(const syntax::TermList &pure_bodies, int capacity) {
+    for (auto& body: pure_bodies) memo_functions[body.get()] = body;
+    memo_capacity = 1;
+    while (memo_capacity < capacity) memo_capacity <<= 1;
+    clearMemo(); memo_table.clear();
+}
+
+void IncreEvaluator::clearMemo() {
+    for (auto index: memo_used) memo_table[index] = MemoEntry();
+    memo_used.clear();
+}
+
+int IncreEvaluator::getMemoIndex(VClosure *closure, const Data &param) {
+    if (memo_functions.empty() || closure->context.frame || !memo_functions.count(closure->body.get())) return -1;
+    if (param.getKind() == DataKind::VALUE && dynamic_cast<VClosure*>(param.get())) return -1;
+    if (memo_table.empty()) memo_table.resize(memo_capacity);
+    auto key = data::hashCombine(std::hash<TermData*>()(closure->body.get()), param.hash());
+    return key & (memo_table.size() - 1);
+}
+
+bool IncreEvaluator::lookupMemo(int index, syntax::TermData *body, const Data &param, Data &res) const {
+    auto& entry = memo_table[index];
+    if (entry.func != body || !(entry.param == param)) return false;
+    res = entry.result; return true;
+}
+
+void IncreEvaluator::storeMemo(int index, syntax::TermData *body, const Data &param, const Data &res) {
+    auto& entry = memo_table[index];
+    if (!entry.func) memo_used.push_back(index);
+    entry.func = body; entry.param = param; entry.result = res;
+}
+
 void DefaultEvaluator::preProcess(syntax::TermData *term, const IncreContext &ctx) {}
 void DefaultEvaluator::postProcess(syntax::TermData *term, const IncreContext &ctx, const Data& res) {}
 
@@ -98,33 +358,36 @@ Data DefaultEvaluator::_evaluate(syntax::TmApp *term, const IncreContext &ctx) {
     EvalAssign(func, ctx); EvalAssign(param, ctx);
     auto* vc = dynamic_cast<VClosure*>(func.get());
     if (!vc) throw IncreSemanticsError("the evaluation result of TmApp func should be a closure, but got " + func.toString());
-    auto new_ctx = vc->context.insert(vc->name, param);
-    return evaluate(vc->body.get(), new_ctx);
+    return applyOne(vc, param);
 }
 
 Data DefaultEvaluator::_evaluate(syntax::TmLet *term, const IncreContext &ctx) {
+    auto* scope = getFrameScope(term);
     if (term->is_rec) {
-        auto new_ctx = ctx.insert(term->name, Data());
-        new_ctx.start->bind.data = Eval(def, new_ctx);
+        auto new_ctx = ctx.pushFrame(scope);
+        new_ctx.frame->slot_list[0] = Eval(def, new_ctx);
         return Eval(body, new_ctx);
     } else {
         EvalAssign(def, ctx);
-        auto new_ctx = ctx.insert(term->name, def);
+        auto new_ctx = ctx.pushFrame(scope);
+        new_ctx.frame->slot_list[0] = def;
         return Eval(body, new_ctx);
     }
 }
 
 Data DefaultEvaluator::_evaluate(syntax::TmVar *term, const IncreContext &ctx) {
-    return ctx.getData(term->name);
+    auto res = ctx.getData(term);
+    if (res.isNull()) LOG(FATAL) << "No data is bound to " << term->name;
+    return res;
 }
 
 Data DefaultEvaluator::_evaluate(syntax::TmCons *term, const IncreContext &ctx) {
     EvalAssign(body, ctx);
-    return Data(std::make_shared<VInd>(term->cons_name, body));
+    return data::makeData<VInd>(term->cons_tag, body);
 }
 
 Data DefaultEvaluator::_evaluate(syntax::TmFunc *term, const IncreContext &ctx) {
-    return Data(std::make_shared<VClosure>(ctx, term->name, term->body));
+    return data::makeData<VClosure>(ctx, term->name, term->body, getFrameScope(term));
 }
 
 Data DefaultEvaluator::_evaluate(syntax::TmProj *term, const IncreContext &ctx) {
@@ -138,7 +401,7 @@ Data DefaultEvaluator::_evaluate(syntax::TmProj *term, const IncreContext &ctx)
 }
 
 Data DefaultEvaluator::_evaluate(syntax::TmLabel *term, const IncreContext &ctx) {
-    return Data(std::make_shared<VCompress>(Eval(body, ctx)));
+    return data::makeData<VCompress>(Eval(body, ctx));
 }
 
 bool incre::semantics::isValueMatchPattern(PatternData *pattern, const Data &data) {
@@ -161,7 +424,7 @@ bool incre::semantics::isValueMatchPattern(PatternData *pattern, const Data &dat
         case PatternType::CONS: {
             auto* pt = dynamic_cast<PtCons*>(pattern);
             auto* vi = dynamic_cast<VInd*>(data.get());
-            if (!vi || vi->name != pt->name) return false;
+            if (!vi || vi->tag != pt->tag) return false;
             return isValueMatchPattern(pt->body.get(), vi->body);
         }
     }
@@ -193,7 +456,7 @@ IncreContext incre::semantics::bindValueWithPattern(syntax::PatternData *pattern
         case PatternType::CONS: {
             auto* pc = dynamic_cast<PtCons*>(pattern);
             auto* vi = dynamic_cast<VInd*>(data.get());
-            if (!vi || vi->name != pc->name) {
+            if (!vi || vi->tag != pc->tag) {
                 throw IncreSemanticsError("value " + data.toString() + "does not match pattern");
             }
             return bindValueWithPattern(pc->body.get(), vi->body, ctx);
@@ -201,11 +464,39 @@ IncreContext incre::semantics::bindValueWithPattern(syntax::PatternData *pattern
     }
 }
 
+void incre::semantics::bindValueToSlots(syntax::PatternData *pattern, const Data &data, Data *&pos) {
+    switch (pattern->getType()) {
+        case PatternType::UNDERSCORE: return;
+        case PatternType::VAR: {
+            auto* pv = dynamic_cast<PtVar*>(pattern);
+            *(pos++) = data;
+            if (pv->body) bindValueToSlots(pv->body.get(), data, pos);
+            return;
+        }
+        case PatternType::TUPLE: {
+            auto* pt = dynamic_cast<PtTuple*>(pattern);
+            auto* vt = dynamic_cast<VTuple*>(data.get());
+            for (int i = 0; i < pt->fields.size(); ++i) bindValueToSlots(pt->fields[i].get(), vt->elements[i], pos);
+            return;
+        }
+        case PatternType::CONS: {
+            auto* pc = dynamic_cast<PtCons*>(pattern);
+            bindValueToSlots(pc->body.get(), dynamic_cast<VInd*>(data.get())->body, pos);
+            return;
+        }
+    }
+}
+
 Data DefaultEvaluator::_evaluate(syntax::TmMatch *term, const IncreContext &ctx) {
     EvalAssign(def, ctx);
-    for (auto& [pt, tm]: term->cases) {
+    for (int i = 0; i < term->cases.size(); ++i) {
+        auto& [pt, tm] = term->cases[i];
         if (isValueMatchPattern(pt.get(), def)) {
-            auto new_ctx = bindValueWithPattern(pt.get(), def, ctx);
+            auto* scope = getFrameScope(term, i);
+            if (scope->empty()) return evaluate(tm.get(), ctx);
+            auto new_ctx = ctx.pushFrame(scope);
+            auto* pos = new_ctx.frame->slot_list.data();
+            bindValueToSlots(pt.get(), def, pos);
             return evaluate(tm.get(), new_ctx);
         }
     }
@@ -3,6 +3,9 @@
 //
 #include "istool/incre/language/incre_syntax.h"
 #include "glog/logging.h"
+#include <deque>
+#include <shared_mutex>
+#include <mutex>
 
 using namespace incre::syntax;
 
@@ -13,7 +16,7 @@ TmValue::TmValue(const Data &_v): TermData(TermType::VALUE), v(_v) {}
 std::string TmValue::toString() const {return v.toString();}
 TmApp::TmApp(const Term &_func, const Term &_param): TermData(TermType::APP), func(_func), param(_param) {}
 std::string TmApp::toString() const {return func->toString() + " " + param->toString();}
-TmCons::TmCons(const std::string &_cons_name, const Term &_body): TermData(TermType::CONS), cons_name(_cons_name), body(_body) {}
+TmCons::TmCons(const std::string &_cons_name, const Term &_body): TermData(TermType::CONS), cons_name(_cons_name), cons_tag(getConsTag(_cons_name)), body(_body) {}
 std::string TmCons::toString() const {return cons_name + " " + body->toString();}
 TmFunc::TmFunc(const std::string &_name, const Term &_body): TermData(TermType::FUNC), name(_name), body(_body) {}
 std::string TmFunc::toString() const {return "fun " + name + " -> " + body->toString();}
@@ -135,7 +138,7 @@ std::string PtVar::toString() const {
     if (body) return "(" + body->toString() + ")@" + name;
     return name;
 }
-PtCons::PtCons(const std::string &_name, const Pattern &_body): PatternData(PatternType::CONS), name(_name), body(_body) {}
+PtCons::PtCons(const std::string &_name, const Pattern &_body): PatternData(PatternType::CONS), name(_name), tag(getConsTag(_name)), body(_body) {}
 std::string PtCons::toString() const {
     return name + " " + body->toString();
 }
@@ -174,7 +177,7 @@ TyInt::TyInt(): TypeData(TypeType::INT) {}
 std::string TyInt::toString() const {return "Int";}
 TyUnit::TyUnit(): TypeData(TypeType::UNIT) {}
 std::string TyUnit::toString() const {return "Unit";}
-TyVar::TyVar(const TypeVarInfo &_info): info(_info), TypeData(TypeType::VAR) {}
+TyVar::TyVar(const TypeVarInfo &_info): info(_info), rank(0), TypeData(TypeType::VAR) {}
 std::string TyVar::toString() const {
     if (is_bounded()) return get_bound_type()->toString();
     auto [index, level, range] = get_var_info();
@@ -302,4 +305,38 @@ std::vector<std::string> incre::syntax::getVarsInPattern(PatternData *pattern) {
     std::vector<std::string> names;
     _getVarsInPattern(pattern, names);
     return names;
-}
\ No newline at end of file
+}
+
+namespace {
+    struct _ConsTable {
+        std::shared_mutex lock;
+        std::unordered_map<std::string, int> tag_map;
+        std::deque<std::string> name_list;
+    };
+
+    _ConsTable& _getConsTable() {
+        static _ConsTable table;
+        return table;
+    }
+}
+
+int incre::syntax::getConsTag(const std::string &name) {
+    auto& table = _getConsTable();
+    {
+        std::shared_lock<std::shared_mutex> guard(table.lock);
+        auto it = table.tag_map.find(name);
+        if (it != table.tag_map.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> guard(table.lock);
+    auto it = table.tag_map.find(name);
+    if (it != table.tag_map.end()) return it->second;
+    int tag = table.name_list.size();
+    table.name_list.push_back(name); table.tag_map[name] = tag;
+    return tag;
+}
+
+const std::string &incre::syntax::getConsName(int tag) {
+    auto& table = _getConsTable();
+    std::shared_lock<std::shared_mutex> guard(table.lock);
+    return table.name_list.at(tag);
+}
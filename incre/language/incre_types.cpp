@@ -60,6 +60,22 @@ void types::checkAndUpdate(syntax::VarRange x, syntax::TypeData* type) {
 }
 
 
+syntax::Ty types::findRepresentative(const syntax::Ty &type) {
+    auto root = type;
+    while (root->getType() == TypeType::VAR) {
+        auto* tv = dynamic_cast<TyVar*>(root.get());
+        if (!tv->is_bounded()) break;
+        root = tv->get_bound_type();
+    }
+    auto now = type;
+    while (now != root) {
+        auto* tv = dynamic_cast<TyVar*>(now.get());
+        auto next = tv->get_bound_type();
+        tv->info = root; now = next;
+    }
+    return root;
+}
+
 syntax::Ty types::getPrimaryType(const std::string &name) {
     if (KIntBinaryOp.find(name) != std::string::npos) return TARR(TINT, TARR(TINT, TINT));
     if (name == "==") {
@@ -133,9 +149,7 @@ syntax::Ty DefaultIncreTypeChecker::instantiate(const syntax::Ty &x) {
             auto it = range_map.find(index); assert(it != range_map.end());
             replace_map[index] = getTmpVar(it->second);
         }
-        auto* rewriter = new _TypeVarRewriter(replace_map);
-        auto res = rewriter->rewrite(xp->body);
-        delete rewriter; return res;
+        return _TypeVarRewriter(replace_map).rewrite(xp->body);
     } else return x;
 }
 
@@ -143,11 +157,10 @@ namespace {
     void _collectLocalVars(TypeData* x, std::unordered_set<int>& local_vars, int level) {
         if (x->getType() == TypeType::VAR) {
             auto* tv = dynamic_cast<TyVar*>(x);
-            if (!tv->is_bounded()) {
-                auto [var_index, var_level, info] = tv->get_var_info();
-                if (var_level > level) local_vars.insert(var_index);
-                return;
-            }
+            if (tv->is_bounded()) return _collectLocalVars(findRepresentative(tv->get_bound_type()).get(), local_vars, level);
+            auto [var_index, var_level, info] = tv->get_var_info();
+            if (var_level > level) local_vars.insert(var_index);
+            return;
         }
         for (auto& subtype: getSubTypes(x)) {
             _collectLocalVars(subtype.get(), local_vars, level);
@@ -176,12 +189,11 @@ syntax::Ty DefaultIncreTypeChecker::generalize(const syntax::Ty &x, TermData* te
 void DefaultIncreTypeChecker::updateLevelBeforeUnification(syntax::TypeData *x, int index, int level) {
     if (x->getType() == TypeType::VAR) {
         auto* tv = dynamic_cast<TyVar*>(x);
-        if (!tv->is_bounded()) {
-            auto [var_index, var_level, info] = tv->get_var_info();
-            if (var_index == index) throw IncreTypingError("infinite unification");
-            tv->info = std::make_tuple(var_index, std::min(var_level, level), info);
-            return;
-        }
+        if (tv->is_bounded()) return updateLevelBeforeUnification(findRepresentative(tv->get_bound_type()).get(), index, level);
+        auto [var_index, var_level, info] = tv->get_var_info();
+        if (var_index == index) throw IncreTypingError("infinite unification");
+        tv->info = std::make_tuple(var_index, std::min(var_level, level), info);
+        return;
     }
     for (auto& subtype: getSubTypes(x)) {
         updateLevelBeforeUnification(subtype.get(), index, level);
@@ -235,13 +247,20 @@ void DefaultIncreTypeChecker::_unify(syntax::TyInd *x, syntax::TyInd *y, const s
     }
 }
 
+// Type variables form a union-find forest, where a bound variable points to its parent. Two unbound variables are
+// united by rank, and chains of bound variables are compressed by findRepresentative.
 void DefaultIncreTypeChecker::_unify(syntax::TyVar *x, syntax::TyVar *y, const syntax::Ty &_x, const syntax::Ty &_y) {
-    if (x->is_bounded()) return unify(x->get_bound_type(), _y);
-    if (y && y->is_bounded()) return unify(_x, y->get_bound_type());
+    if (x->is_bounded() || (y && y->is_bounded())) return unify(findRepresentative(_x), findRepresentative(_y));
+    if (y && x->rank > y->rank) return bindVar(y, x, _y, _x);
+    return bindVar(x, y, _x, _y);
+}
+
+void DefaultIncreTypeChecker::bindVar(syntax::TyVar *x, syntax::TyVar *y, const syntax::Ty &_x, const syntax::Ty &_y) {
     auto [x_index, x_level, x_range] = x->get_var_info();
     if (y && std::get<0>(y->get_var_info()) == x_index) return;
     updateLevelBeforeUnification(_y.get(), x_index, x_level);
     checkAndUpdate(x_range, _y.get());
+    if (y && y->rank == x->rank) ++y->rank;
     x->info = _y;
 }
 
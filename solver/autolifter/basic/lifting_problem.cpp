@@ -12,7 +12,7 @@
 #include <iostream>
 
 DataList* LiftingCache::registerProgram(Program *program, const DataList &res) {
-    auto feature = program->toString();
+    auto feature = program->getFingerprint();
     if (program_map.find(feature) != program_map.end()) {
         LOG(FATAL) << "Program " << program->toString() << " has been cached";
     }
@@ -22,7 +22,7 @@ DataList* LiftingCache::registerProgram(Program *program, const DataList &res) {
     return item;
 }
 DataList * LiftingCache::getCache(Program *program) {
-    auto feature = program->toString();
+    auto feature = program->getFingerprint();
     auto it = program_map.find(feature);
     if (it == program_map.end()) return nullptr;
     return cache[it->second];
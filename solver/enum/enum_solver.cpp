@@ -62,18 +62,18 @@ FunctionContext OBESolver::synthesis(const std::vector<Example> &example_list, T
     std::unordered_map<std::string, ExampleList> example_pool;
     for (auto& invoke_info: invoke_map) {
         std::string name = invoke_info.first;
-        std::unordered_set<std::string> feature_set;
+        std::unordered_set<DataList, data::DataListHash> feature_set;
         ExampleList res;
         for (const auto& p: invoke_info.second) {
-            for (const auto& example: example_list) {
+            std::vector<DataList> column_list;
+            for (const auto& sub: p->sub_list) {
+                column_list.push_back(spec->env->runBatch(sub.get(), example_list));
+            }
+            for (int i = 0; i < example_list.size(); ++i) {
                 Example invoke_example;
-                for (const auto& sub: p->sub_list) {
-                    invoke_example.push_back(spec->env->run(sub.get(), example));
-                }
-                auto feature = data::dataList2String(invoke_example);
-                if (feature_set.find(feature) == feature_set.end()) {
+                for (auto& column: column_list) invoke_example.push_back(column[i]);
+                if (feature_set.insert(invoke_example).second) {
                     res.push_back(invoke_example);
-                    feature_set.insert(feature);
                 }
             }
         }
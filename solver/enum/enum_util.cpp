@@ -63,28 +63,33 @@ const std::unordered_set<std::string> RuleBasedOptimizer::KAssocOpSet = {"+", "*
 OBEOptimizer::OBEOptimizer(ProgramChecker* _is_runnable, const std::unordered_map<std::string, ExampleList> &_pool, Env* _env):
         is_runnable(_is_runnable), example_pool(_pool), env(_env) {
 }
+ProgramEvalCache *OBEOptimizer::getCache(const std::string &name) {
+    auto it = cache_pool.find(name);
+    if (it != cache_pool.end()) return it->second;
+    auto* cache = new ProgramEvalCache(example_pool[name], env);
+    cache_pool[name] = cache;
+    return cache;
+}
 bool OBEOptimizer::isDuplicated(const std::string& name, NonTerminal *nt, const PProgram &p) {
     if (!is_runnable->isValid(p.get()) || example_pool.find(name) == example_pool.end()) return false;
-    auto& example_list = example_pool[name];
-    DataList res;
-    for (auto& example: example_list) {
-        try {
-            res.push_back(env->run(p.get(), example));
-        } catch (SemanticsError& e) {
-            return true;
-        }
+    auto* cache = getCache(name);
+    auto res = cache->run(p);
+    for (auto& d: res) {
+        if (d.isError()) return true;
     }
-    std::string feature = std::to_string(nt->id) + "@" + data::dataList2String(res);
-    if (visited_set.find(feature) != visited_set.end()) return true;
-    visited_set.insert(feature);
+    if (!visited_set[nt->id].insert(res).second) return true;
+    cache->insert(p, res);
     return false;
 }
 void OBEOptimizer::clear() {
     visited_set.clear();
+    for (auto& [name, cache]: cache_pool) delete cache;
+    cache_pool.clear();
 }
 // TODO: change the type of is_runnable to PProgramChecker to avoid memory leak;
 OBEOptimizer::~OBEOptimizer() {
     // delete is_runnable;
+    for (auto& [name, cache]: cache_pool) delete cache;
 }
 
 NumberLimitedVerifier::NumberLimitedVerifier(int _n, Verifier* _v): n(_n), v(_v) {}
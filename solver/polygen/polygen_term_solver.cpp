@@ -109,7 +109,7 @@ void AssignmentInfo::update(const ExampleList &example_list, ExampleSpace *examp
 }
 
 AssignmentInfo * PolyGenTermSolver::buildAssignmentInfo(const FunctionContext &term) {
-    auto feature = term.toString();
+    auto feature = term.getFingerprint();
     if (cache[solver_id]->info_map.count(feature)) {
         auto* res = cache[solver_id]->info_map[feature];
         res->update(example_list, spec->example_space.get());
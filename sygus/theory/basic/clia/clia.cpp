@@ -13,7 +13,7 @@ namespace {
 #define LoadINFSemantics(name, sem) env->setSemantics(name, std::make_shared<sem ## Semantics>(inf))
 
 void theory::loadCLIATheory(Env *env) {
-    auto* inf = env->getConstRef(theory::clia::KINFName, Data(std::make_shared<IntValue>(KDefaultINF)));
+    auto* inf = env->getConstRef(theory::clia::KINFName, BuildData(Int, KDefaultINF));
     LoadINFSemantics("+", IntPlus);
     LoadINFSemantics("-", IntMinus);
     LoadINFSemantics("*", IntTimes);
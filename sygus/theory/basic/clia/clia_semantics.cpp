@@ -15,6 +15,54 @@ namespace {
     }
 }
 
+namespace {
+    std::vector<int> _getIntColumn(const DataList& column) {
+        std::vector<int> res(column.size());
+        for (int i = 0; i < column.size(); ++i) res[i] = getIntValue(column[i]);
+        return res;
+    }
+
+    DataList _buildIntColumn(const std::vector<int>& column) {
+        DataList res(column.size());
+        for (int i = 0; i < column.size(); ++i) res[i] = BuildData(Int, column[i]);
+        return res;
+    }
+
+    DataList _buildBoolColumn(const std::vector<char>& column) {
+        DataList res(column.size());
+        for (int i = 0; i < column.size(); ++i) res[i] = BuildData(Bool, column[i]);
+        return res;
+    }
+
+    bool _isIntColumn(const DataList& column) {
+        for (auto& d: column) {
+            if (!d.isInlinedInt()) return false;
+        }
+        return true;
+    }
+}
+
+// The batched integer kernels work on contiguous int arrays, and the overflow checks are accumulated without branches.
+#define INT_BATCH(op) \
+    int inf_val = getIntValue(*inf); \
+    auto x = _getIntColumn(inp_list[0]), y = _getIntColumn(inp_list[1]); \
+    std::vector<int> res(x.size()); bool is_overflow = false; \
+    for (int i = 0; i < x.size(); ++i) { \
+        long long w = op; \
+        is_overflow |= std::abs(w) > inf_val; res[i] = int(w); \
+    } \
+    if (is_overflow) throw SemanticsError(); \
+    return _buildIntColumn(res)
+
+#define COMPARE_BATCH(op) \
+    if (!_isIntColumn(inp_list[0]) || !_isIntColumn(inp_list[1])) { \
+        return FullExecutedSemantics::runBatch(std::move(inp_list), info_list); \
+    } \
+    auto x = _getIntColumn(inp_list[0]), y = _getIntColumn(inp_list[1]); \
+    std::vector<char> res(x.size()); \
+    for (int i = 0; i < x.size(); ++i) res[i] = op; \
+    return _buildBoolColumn(res)
+
 #define TINT theory::clia::getTInt()
 #define TBOOL type::getTBool()
 #define TVARA getVar()
@@ -26,9 +74,12 @@ Data IntPlusSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     int inf_val = getIntValue(*inf);
     int w = getIntValue(inp_list[0]) + getIntValue(inp_list[1]);
     if (std::abs(w) > inf_val) {
-        throw SemanticsError();
+        return data::buildError();
     }
-    return Data(std::make_shared<IntValue>(w));
+    return BuildData(Int, w);
+}
+DataList IntPlusSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    INT_BATCH(int(x[i] + y[i]));
 }
 
 IntMinusSemantics::IntMinusSemantics(Data *_inf): inf(_inf),
@@ -38,9 +89,12 @@ Data IntMinusSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     int inf_val = getIntValue(*inf);
     int w = getIntValue(inp_list[0]) - getIntValue(inp_list[1]);
     if (std::abs(w) > inf_val) {
-        throw SemanticsError();
+        return data::buildError();
     }
-    return Data(std::make_shared<IntValue>(w));
+    return BuildData(Int, w);
+}
+DataList IntMinusSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    INT_BATCH(int(x[i] - y[i]));
 }
 
 IntTimesSemantics::IntTimesSemantics(Data* _inf): inf(_inf),
@@ -50,78 +104,103 @@ Data IntTimesSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     int inf_val = getIntValue(*inf);
     long long w = 1ll* getIntValue(inp_list[0]) * getIntValue(inp_list[1]);
     if (std::abs(w) > inf_val) {
-        throw SemanticsError();
+        return data::buildError();
     }
-    return Data(std::make_shared<IntValue>(int(w)));
+    return BuildData(Int, int(w));
+}
+DataList IntTimesSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    INT_BATCH(1ll * x[i] * y[i]);
 }
 
 IntDivSemantics::IntDivSemantics(): NormalSemantics("div", TINT, {TINT, TINT}) {
 }
 Data IntDivSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     int x = getIntValue(inp_list[0]), y = getIntValue(inp_list[1]);
-    if (y == 0) throw SemanticsError();
-    return Data(std::make_shared<IntValue>(x / y));
+    if (y == 0) return data::buildError();
+    return BuildData(Int, x / y);
 }
 
 IntModSemantics::IntModSemantics(): NormalSemantics("mod", TINT, {TINT, TINT}) {
 }
 Data IntModSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     int x = getIntValue(inp_list[0]), y = getIntValue(inp_list[1]);
-    if (y == 0) throw SemanticsError();
-    return Data(std::make_shared<IntValue>(x % y));
+    if (y == 0) return data::buildError();
+    return BuildData(Int, x % y);
 }
 
 LqSemantics::LqSemantics(): NormalSemantics("<", TBOOL, {TVARA, TVARA}) {
 }
 Data LqSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
-    return Data(std::make_shared<BoolValue>(inp_list[0] < inp_list[1]));
+    return BuildData(Bool, inp_list[0] < inp_list[1]);
+}
+DataList LqSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    COMPARE_BATCH(x[i] < y[i]);
 }
 
 LeqSemantics::LeqSemantics(): NormalSemantics("<=", TBOOL, {TVARA, TVARA}) {
 }
 Data LeqSemantics::run(DataList &&inp_list, ExecuteInfo* info) {
-    return Data(std::make_shared<BoolValue>(inp_list[0] <= inp_list[1]));
+    return BuildData(Bool, inp_list[0] <= inp_list[1]);
+}
+DataList LeqSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    COMPARE_BATCH(x[i] <= y[i]);
 }
 
 GqSemantics::GqSemantics(): NormalSemantics(">", TBOOL, {TVARA, TVARA}) {
 }
 Data GqSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
-    return Data(std::make_shared<BoolValue>(inp_list[1] < inp_list[0]));
+    return BuildData(Bool, inp_list[1] < inp_list[0]);
+}
+DataList GqSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    COMPARE_BATCH(y[i] < x[i]);
 }
 
 GeqSemantics::GeqSemantics(): NormalSemantics(">=", TBOOL, {TVARA, TVARA}) {
 }
 Data GeqSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
-    return Data(std::make_shared<BoolValue>(inp_list[1] <= inp_list[0]));
+    return BuildData(Bool, inp_list[1] <= inp_list[0]);
+}
+DataList GeqSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    COMPARE_BATCH(y[i] <= x[i]);
 }
 
 EqSemantics::EqSemantics(): NormalSemantics("=", TBOOL, {TVARA, TVARA}) {
 }
 Data EqSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
-    return Data(std::make_shared<BoolValue>(inp_list[0] == inp_list[1]));
+    return BuildData(Bool, inp_list[0] == inp_list[1]);
 }
 
 EqBoolSemantics::EqBoolSemantics(): NormalSemantics("=b", TBOOL, {TBOOL, TBOOL}) {
 }
 Data EqBoolSemantics::run(DataList &&inp_list, ExecuteInfo* info) {
-    return Data(std::make_shared<BoolValue>(inp_list[0] == inp_list[1]));
+    return BuildData(Bool, inp_list[0] == inp_list[1]);
 }
 
 NeqSemantics::NeqSemantics(): NormalSemantics("!=", TBOOL, {TVARA, TVARA}) {
 }
 Data NeqSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
-    return Data(std::make_shared<BoolValue>(!(inp_list[0] == inp_list[1])));
+    return BuildData(Bool, !(inp_list[0] == inp_list[1]));
 }
 
 IteSemantics::IteSemantics(): NormalSemantics("ite", TVARA, {TBOOL, TVARA, TVARA}) {
 }
 Data IteSemantics::run(const ProgramList &sub_list, ExecuteInfo *info) {
     auto c = sub_list[0]->run(info);
+    if (c.isError()) return c;
     if (c.isTrue()) return sub_list[1]->run(info);
     return sub_list[2]->run(info);
 }
 Data IteSemantics::run(DataList &&inp_list, ExecuteInfo *info) {
     if (inp_list[0].isTrue()) return inp_list[1]; else return inp_list[2];
 }
+bool IteSemantics::isLazy() const {
+    return true;
+}
+DataList IteSemantics::runBatch(std::vector<DataList> &&inp_list, const std::vector<ExecuteInfo *> &info_list) {
+    auto& c = inp_list[0];
+    DataList res(c.size());
+    for (int i = 0; i < c.size(); ++i) res[i] = std::move(c[i].isTrue() ? inp_list[1][i] : inp_list[2][i]);
+    return res;
+}
 
 const std::string theory::clia::KINFName = "CLIA@INF";
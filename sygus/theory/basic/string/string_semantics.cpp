@@ -97,7 +97,7 @@ Data StrToIntSemantics::run(DataList &&inp_list, ExecuteInfo* info) {
     int res = 0;
     for (char c: s) {
         long long ne = 10ll * res + int(c - '0');
-        if (ne > getIntValue(*inf)) throw SemanticsError();
+        if (ne > getIntValue(*inf)) return data::buildError();
         res = ne;
     }
     return BuildData(Int, res);